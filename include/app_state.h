@@ -0,0 +1,76 @@
+// app_state.h - what the NFC, audio and UI tasks (app_tasks.h) tell each other
+//
+// The audio task owns the player and the playback state. The other two never
+// touch it directly:
+//   - the NFC task sends tag events (placed / removed / rewritten...)
+//   - the UI task sends button events
+// both through single-producer queues that only the audio task drains. The
+// audio task in turn publishes a BoxState snapshot that anyone can read.
+
+#ifndef APP_STATE_H
+#define APP_STATE_H
+
+#include <Arduino.h>
+#include "spsc_queue.h"
+#include "tag_parser.h"
+
+// ---- NFC task -> audio task ----
+enum TagEventType : uint8_t {
+  TAG_PLACED,       // a readable record: play `cmd`
+  TAG_REWRITTEN,    // the record on the reader changed (cache verify): switch to `cmd`
+  TAG_UNREADABLE,   // a tag without a usable record
+  TAG_REMOVED,
+  TAG_READER_HEALTH // `ok`: PN532 answering
+};
+
+struct TagEvent {
+  TagEventType type;
+  uint8_t uid[7];
+  uint8_t uidLen;
+  TagCommand cmd;
+  uint32_t startUs;   // PLACED: detection started; REMOVED: first poll that missed it
+  bool fromCache;
+  bool ok;
+};
+
+// ---- UI task -> audio task ----
+enum UiEventType : uint8_t {
+  UI_VOLUME_UP,
+  UI_VOLUME_DOWN,
+  UI_NEXT_TRACK,
+  UI_PREVIOUS_TRACK,
+};
+
+struct UiEvent {
+  UiEventType type;
+  uint32_t startUs;   // when the scan saw the press (button latency path)
+};
+
+extern SpscQueue<TagEvent, 8> tagEvents;
+extern SpscQueue<UiEvent, 8> uiEvents;
+
+// Push and wake the audio task
+bool sendTagEvent(const TagEvent &e);
+bool sendUiEvent(UiEventType type, uint32_t startUs);
+
+// ---- Audio task -> everyone ----
+struct BoxState {
+  bool playing;       // a record is on the reader and playing
+  bool tagError;      // the tag on the reader has no usable record
+  uint8_t uid[7];
+  uint8_t uidLen;
+  uint16_t folder;
+  int volume;
+  bool dfplayerOK;
+  bool nfcOK;
+  bool batteryLow;    // LOW, or below BATT_WARN_PERCENT: time to charge
+  bool booting;       // a peripheral's bring-up hasn't answered yet (boot.h)
+};
+
+// Seqlock: the writer (audio task only) never waits; a reader retries if it
+// caught a half-written copy. The audio task has the highest priority, so a
+// reader can't preempt a write and spin on it.
+void publishBoxState(const BoxState &s);
+BoxState readBoxState();
+
+#endif // APP_STATE_H
@@ -0,0 +1,67 @@
+// app_tasks.h - the firmware's FreeRTOS tasks
+//
+//   audio (priority 4)  owns the DFPlayer: playback, chimes, battery, DFPlayer health
+//   ui    (priority 3)  buttons (edges from their interrupt), status light, console,
+//                       stats, telemetry uploads
+//   nfc   (priority 2)  tag polling / IRQ, NDEF reads, tag cache, PN532 health
+//
+// Each task runs its own cooperative Scheduler (scheduler.h): it drains its
+// inbound queue (app_state.h), runs whatever is due, then blocks until its
+// next deadline or a notification. A long SPI exchange in the NFC task gets
+// preempted by button scans and DFPlayer traffic instead of holding them up.
+//
+// loop() runs below all of them, i.e. only when every task is blocked; that's
+// where the power manager (power.h) decides about light sleep.
+//
+// With APP_TASKS_RTOS false, or where a task can't be created (on the host
+// there is no FreeRTOS), its scheduler is stepped from loop() instead.
+
+#ifndef APP_TASKS_H
+#define APP_TASKS_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+enum AppTaskId : uint8_t {
+  APP_TASK_AUDIO,
+  APP_TASK_UI,
+  APP_TASK_NFC,
+  APP_TASK_COUNT
+};
+
+extern Scheduler audioScheduler;
+extern Scheduler uiScheduler;
+extern Scheduler nfcScheduler;
+
+// Register each task's periodic work (audio_task.cpp, ui_task.cpp, nfc_task.cpp)
+void audioTaskBegin();
+void uiTaskBegin();
+void nfcTaskBegin();
+
+// Run at the start of every round: queued tag and button events (audio),
+// button edges (ui)
+void audioTaskDrain();
+void uiTaskDrain();
+
+// Unsolicited DFPlayer frames; registered in setup() so the boot frames are seen too
+void audioPlayerEvent(uint8_t event, uint16_t param);
+
+void appTasksStart();               // spawn the tasks; call at the end of setup()
+void appTasksLoop();                // call from loop()
+void appTaskNotify(AppTaskId id);   // wake a task early: something was queued for it
+void appTaskNotifyFromIsr(AppTaskId id);
+void appTasksWakeAll();             // after light sleep, which stops the tick
+
+// Replaces the plain delay() in loop() when every task is waiting, e.g. with
+// light sleep. Gets the ms until the next deadline (never 0).
+typedef void (*IdleFn)(unsigned long msToNext);
+void appTasksSetIdleHandler(IdleFn fn);
+
+// Earliest deadline over all tasks; 0 if something is due
+unsigned long appTasksMsUntilNext(bool skipSleepable = false);
+
+// CPU share, worst round and stack headroom per task, then each scheduler's own stats
+void appTasksPrintStats();
+void appTasksResetStats();
+
+#endif // APP_TASKS_H
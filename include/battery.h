@@ -0,0 +1,42 @@
+// battery.h - background battery monitor
+//
+// A scheduler task takes one ADC reading of the divider on VoltageReader_Pin
+// every BATT_SAMPLE_INTERVAL (a single oneshot conversion, no delay()). Each
+// reading is corrected for the sag while the amplifier is driving the speaker,
+// kept in a small ring, and the median of the ring feeds an EMA; one glitch
+// during a loud passage can't move the result.
+//
+// The state changes with hysteresis: LOW below LOW_BAT_THRESHOLD, OK again
+// only above WAKE_BAT_THRESHOLD. Below NO_BAT_THRESHOLD there is no battery
+// (running from USB).
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <Arduino.h>
+
+enum BatteryState : uint8_t {
+  BATT_NONE,
+  BATT_OK,
+  BATT_LOW,
+};
+
+// Returns true while the speaker is playing (and the battery sags)
+typedef bool (*BatteryLoadFn)();
+
+// Fill the filter with a burst of readings so the state is valid right away.
+// `startLow` starts in LOW, e.g. after a low-battery sleep, so the box only
+// carries on once the battery has recovered past WAKE_BAT_THRESHOLD.
+void batteryBegin(bool startLow, BatteryLoadFn underLoad);
+
+// Scheduled every BATT_SAMPLE_INTERVAL
+void batterySample();
+
+float batteryVolts();        // filtered, load-compensated
+uint8_t batteryPercent();    // LiPo state of charge from batteryVolts()
+BatteryState batteryState();
+const char *batteryStateName(BatteryState s);
+
+void batteryPrint();
+
+#endif // BATTERY_H
@@ -0,0 +1,95 @@
+// board.h - compile-time hardware profiles
+//
+// Everything that differs between the boxes we build: wiring, the battery
+// divider and cutoffs, the speaker's volume range. One profile is picked per
+// PlatformIO env with a -DBOARD_... build flag (platformio.ini); config.h
+// turns it into the constexpr names the rest of the firmware uses, so pin
+// numbers and thresholds fold into the code instead of being read from RAM.
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+struct BoardProfile {
+  const char *name;
+
+  // GPIO (-1 = not fitted)
+  int8_t statusLightR, statusLightG, statusLightB;
+  int8_t button1, button2;  // capacitive touch pads, active low (volume down, volume up)
+  int8_t powerSwitch;       // LOW = on; also the deep-sleep wake pin
+  int8_t voltageReader;     // battery divider into the ADC
+  int8_t spiMiso, spiMosi, spiSck, spiCs; // PN532, bit-banged SPI
+  int8_t nfcIrq;            // PN532 IRQ, active low
+  int8_t uartTx, uartRx;    // DFPlayer Mini
+  int8_t dfBusy;            // DFPlayer BUSY, low while audio plays (playback.h)
+
+  // Battery (single LiPo cell)
+  float batteryDivider;     // cell voltage / ADC pin voltage
+  float noBatteryV;         // below this there is no cell, just USB
+  float lowBatteryV;        // deep-sleep below this
+  float wakeBatteryV;       // LOW only clears above this (hysteresis)
+  float audioSagV;          // cell sag with the speaker at maxVolume
+
+  // Speaker
+  int8_t maxVolume;         // DFPlayer volume is 0..30
+  int8_t defaultVolume;
+};
+
+// The original box: XIAO ESP32-C6, PN532 IRQ not wired (timed polling)
+constexpr BoardProfile BOARD_PROFILE_XIAO_C6 = {
+  "xiao-c6",
+  0, 1, 2,
+  22, 23,
+  5,
+  4,
+  20, 18, 19, 21,
+  -1,
+  16, 17,
+  -1,
+  2.0f, 2.0f, 3.4f, 3.6f, 0.12f,
+  30, 15,
+};
+
+// Same board with the two status lines wired to the back pads: PN532 IRQ
+// on MTCK (nfc_detect.h), DFPlayer BUSY on MTDO (playback.h)
+constexpr BoardProfile withStatusLines(BoardProfile b, const char *name, int8_t nfcIrq, int8_t dfBusy) {
+  b.name = name;
+  b.nfcIrq = nfcIrq;
+  b.dfBusy = dfBusy;
+  return b;
+}
+constexpr BoardProfile BOARD_PROFILE_XIAO_C6_IRQ = withStatusLines(BOARD_PROFILE_XIAO_C6, "xiao-c6-irq", 6, 7);
+
+#if defined(BOARD_XIAO_C6_IRQ)
+constexpr BoardProfile BOARD = BOARD_PROFILE_XIAO_C6_IRQ;
+#else // BOARD_XIAO_C6, also the default (native sim)
+constexpr BoardProfile BOARD = BOARD_PROFILE_XIAO_C6;
+#endif
+
+
+// ---- Wiring checks ----
+
+constexpr bool boardPinsDistinct(const BoardProfile &b) {
+  const int8_t pins[] = {b.statusLightR, b.statusLightG, b.statusLightB, b.button1, b.button2,
+                         b.powerSwitch, b.voltageReader, b.spiMiso, b.spiMosi, b.spiSck, b.spiCs,
+                         b.nfcIrq, b.uartTx, b.uartRx, b.dfBusy};
+  const int n = sizeof(pins) / sizeof(pins[0]);
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      if (pins[i] >= 0 && pins[i] == pins[j]) return false;
+    }
+  }
+  return true;
+}
+
+static_assert(boardPinsDistinct(BOARD), "board profile uses a GPIO twice");
+// ESP32-C6: only the LP GPIOs (0-7) can wake the chip from deep sleep (ext1)
+static_assert(BOARD.powerSwitch >= 0 && BOARD.powerSwitch <= 7, "the power switch must be an LP GPIO");
+static_assert(BOARD.noBatteryV < BOARD.lowBatteryV && BOARD.lowBatteryV < BOARD.wakeBatteryV,
+              "battery thresholds must rise: none < low < wake");
+static_assert(BOARD.batteryDivider >= 1.0f, "the divider can only scale the cell voltage down");
+static_assert(BOARD.maxVolume > 0 && BOARD.maxVolume <= 30, "DFPlayer volume is 0..30");
+static_assert(BOARD.defaultVolume >= 0 && BOARD.defaultVolume <= BOARD.maxVolume, "default volume out of range");
+
+#endif // BOARD_H
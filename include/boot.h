@@ -0,0 +1,33 @@
+// boot.h - boot timeline, and what the last run knew about the peripherals
+//
+// setup() no longer waits on anything. It queues the DFPlayer's reset and
+// starts the tasks; the PN532 is brought up by a job in the NFC task while the
+// module resets (nfc_task.cpp), and the audio task hears the reset complete,
+// or time out after DFPlayer::RESET_TIMEOUT_MS (audio_task.cpp). The status
+// light shows "booting" until both have an answer; then the startup chime
+// plays and the timeline is logged. The first tag read is reported whenever
+// it happens, since that is when the box has become useful.
+//
+// Across the low-battery deep sleep both modules stay powered, so a wake from
+// it that finds the battery recovered trusts what the sleeping run knew
+// (kept in RTC memory) instead of resetting and probing them again. A power
+// cut clears RTC memory, and with it the shortcut.
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// Timestamp a phase (ms since reset). Any task; `phase` must be a literal.
+void bootMark(const char *phase);
+void bootPrintTimeline(); // audio task, once both peripherals have answered
+void bootTagRead();       // NFC task, on every new tag: the first one is reported
+
+// ---- RTC memory ----
+void bootRememberPeripherals(bool dfplayer, bool reader); // before the low-battery deep sleep
+// On a wake from that sleep: both peripherals were fine and are still powered.
+// Decided once (bootBegin); the remembered state is used up either way.
+void bootBegin(bool lowBatteryWake);
+bool bootResumed();
+
+#endif // BOOT_H
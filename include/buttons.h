@@ -0,0 +1,47 @@
+// buttons.h - interrupt-driven buttons
+//
+// A GPIO interrupt on each pad timestamps every edge into a lock-free ring
+// (spsc_queue.h). The UI task replays the edges through a debounce / long
+// press / auto-repeat state machine. Gestures are judged by the edge
+// timestamps, not by when the UI task gets to them, so a busy task delays a
+// press but never loses or misjudges it.
+//
+// What each gesture does is the button map in buttons.cpp: volume steps
+// (held = repeating steps) by default, track skipping with
+// BUTTONS_SKIP_TRACKS (config.h).
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <Arduino.h>
+
+enum ButtonAction {
+  BUTTON_NONE,
+  BUTTON_SHORT,
+  BUTTON_LONG,
+  BUTTON_REPEAT
+};
+
+struct ButtonState {
+  uint32_t pressStartUs;
+  uint32_t nextRepeatUs;
+  bool pressed;
+  bool longPressFired;
+};
+
+// The state machine on its own: no I/O or clock reads, so synthetic edge
+// traces can drive it on the host.
+//   buttonEdge: a debounced press / release at `atUs`
+//   buttonHeld: the next long-press or repeat gesture due by `nowUs`, if any,
+//               and when it fell due (call until BUTTON_NONE to catch up
+//               after a stall)
+ButtonAction buttonEdge(ButtonState &s, bool pressed, uint32_t atUs);
+ButtonAction buttonHeld(ButtonState &s, uint32_t nowUs, bool repeats, uint32_t &dueUs);
+
+void buttonsBegin();    // pins and edge interrupts
+void buttonsService();  // UI task: replay queued edges, fire held gestures
+bool buttonsHeld();     // any button down, as far as the replayed edges go
+void buttonsResync();   // after light sleep: queue edges the sleep swallowed
+void buttonsPrintStats();
+
+#endif // BUTTONS_H
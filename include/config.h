@@ -4,28 +4,35 @@
 // ======== Library initialization ========
 // Keep includes minimal in headers to avoid include-depth problems.
 #include <Arduino.h>
-#include <WiFi.h>
-#include <SPI.h>
-#include <PubSubClient.h>
-#include <Adafruit_NeoPixel.h>
+#include "board.h"
 
 
 // Forward declarations for types defined in .cpp files / external libs
-class Adafruit_PN532; // forward declare PN532 class
-class DFRobotDFPlayerMini; // forward declare DFPlayer class
+class NfcReader; // forward declare NFC reader interface (hal.h)
+class DFPlayer; // forward declare DFPlayer class
 
 
 // ======== Configuration constants ========
-// Keep config.h small; peripheral objects live in peripherals.h
+// Keep config.h small; peripheral objects live in peripherals.h.
+// Tunables are constexpr (hardware ones come from the board profile,
+// board.h); only runtime state is defined in config.cpp.
 
 // ======== GPIO & I2C Declarations ========
-extern const int Button1_pin; // GPIO pin for capacitive touch button data line
-extern const int Button2_pin; // GPIO pin for capacitive touch button data line
-extern uint8_t VoltageReader_Pin; // GPIO pin for battery voltage reader
-extern uint8_t StatusLight_R_Pin;
-extern uint8_t StatusLight_G_Pin;
-extern uint8_t StatusLight_B_Pin;
-extern uint8_t Switch_pin; // Deep sleep switch
+constexpr int Button1_pin = BOARD.button1; // GPIO pin for capacitive touch button data line
+constexpr int Button2_pin = BOARD.button2; // GPIO pin for capacitive touch button data line
+constexpr uint8_t VoltageReader_Pin = BOARD.voltageReader; // GPIO pin for battery voltage reader
+constexpr uint8_t StatusLight_R_Pin = BOARD.statusLightR;
+constexpr uint8_t StatusLight_G_Pin = BOARD.statusLightG;
+constexpr uint8_t StatusLight_B_Pin = BOARD.statusLightB;
+constexpr uint8_t Switch_pin = BOARD.powerSwitch; // Deep sleep switch
+constexpr int NFC_IRQ_pin = BOARD.nfcIrq; // PN532 IRQ (active low); -1 = not wired, poll instead
+constexpr int SPI_MISO_PIN = BOARD.spiMiso; // PN532 bit-banged SPI
+constexpr int SPI_MOSI_PIN = BOARD.spiMosi;
+constexpr int SPI_SCK_PIN = BOARD.spiSck;
+constexpr int SPI_CS_PIN = BOARD.spiCs;
+constexpr int UART_TX_pin = BOARD.uartTx; // DFPlayer UART
+constexpr int UART_RX_pin = BOARD.uartRx;
+constexpr int DF_BUSY_pin = BOARD.dfBusy; // DFPlayer BUSY (low = playing); -1 = not wired, frames only
 
 // ======== Global variables ========
 extern unsigned long lastTagSeen;
@@ -33,37 +40,113 @@ extern bool hasPlayedForCurrentTag;
 extern bool tagPresent;
 extern uint8_t currentUID[7];
 extern uint8_t currentUIDLength;
-extern const int DEFAULT_VOLUME;
 extern int volume;
-extern int volume_boost; 
-extern int MAX_VOLUME;
-extern int MIN_VOLUME;
-extern const unsigned long TAG_TIMEOUT; // ms: consider 700-1500 depending on your UX
-extern const unsigned long POST_READ_COOLDOWN; // ms to wait after a successful read
+extern int volume_boost; // a holder for the previous volume setting if using a tag with a specified additive level
+constexpr int DEFAULT_VOLUME = BOARD.defaultVolume;
+constexpr int MAX_VOLUME = BOARD.maxVolume;
+constexpr int MIN_VOLUME = 0;
+constexpr unsigned long TAG_REMOVAL_DEBOUNCE = 250; // ms a tag must go unseen before it counts as removed
+constexpr unsigned long POST_READ_COOLDOWN = 750; // ms to wait after a successful read
+constexpr size_t NTAG_USER_MEMORY_MAX = 888; // NTAG216 user memory; NDEF reads never go past this
 
 // Button press timing
-extern uint64_t LONG_PRESS_TIME;
-extern uint64_t DEBOUNCE_TIME;
-extern uint64_t REPEAT_INTERVAL;
+constexpr unsigned long LONG_PRESS_TIME = 1000;
+constexpr unsigned long DEBOUNCE_TIME = 100;
+constexpr unsigned long REPEAT_INTERVAL = 750;
+constexpr unsigned long BUTTON_SCAN_INTERVAL = 10; // ms between long-press / repeat checks while a button is held
+constexpr bool BUTTONS_SKIP_TRACKS = false; // buttons skip tracks instead of stepping the volume (buttons.cpp)
 
 // NFC reader timing
 extern unsigned long lastNfcCheck;
-extern const unsigned long nfcInterval;
+constexpr unsigned long nfcInterval = 1500; // slowest idle poll, reached after backing off
+constexpr unsigned long NFC_IRQ_CHECK_INTERVAL = 5; // ms between checks for a posted IRQ
+constexpr unsigned long NFC_REARM_BACKOFF = 500; // ms between attempts when arming IRQ detection fails (nfc_detect.cpp)
+constexpr uint8_t NFC_POLL_ACTIVATION_RETRIES = 1; // PN532 retries per one-shot tag poll; only an armed IRQ detection retries forever (0xFF)
+
+// Adaptive polling (without the IRQ wire): fast right after a removal or boot,
+// when the next record is likely, then backing off step by step to nfcInterval
+constexpr unsigned long NFC_POLL_FAST_INTERVAL = 150; // ms between polls in the fast window
+constexpr unsigned long NFC_POLL_FAST_WINDOW = 8000; // ms the fast window lasts
+constexpr float NFC_POLL_BACKOFF = 1.5; // interval multiplier per empty poll after the window
+constexpr unsigned long NFC_PRESENCE_INTERVAL = 100; // ms between presence checks while a tag plays (nfc_task.cpp)
+constexpr bool NFC_POWER_DOWN = true; // PN532 PowerDown between polls
 
 
 // Battery checking timing and thresholds
-extern float NO_BAT_THRESHOLD;
-extern float LOW_BAT_THRESHOLD; // A limit point to trigger deep sleep if the battery is too low
-extern uint64_t Batt_Check_Interval;
-extern uint64_t LOW_BAT_SLEEP_INTERVAL; // Minutes between battery checks while charging
-extern int WAKE_BAT_THRESHOLD; 
+constexpr float NO_BAT_THRESHOLD = BOARD.noBatteryV;
+constexpr float LOW_BAT_THRESHOLD = BOARD.lowBatteryV; // A limit point to trigger deep sleep if the battery is too low
+constexpr float WAKE_BAT_THRESHOLD = BOARD.wakeBatteryV; // LOW only clears above this (hysteresis)
+constexpr float BATT_DIVIDER_RATIO = BOARD.batteryDivider;
+constexpr float BATT_AUDIO_SAG_V = BOARD.audioSagV; // battery sag with the speaker at MAX_VOLUME, added back to readings
+constexpr unsigned long Batt_Check_Interval = 60000; // ms between acting on the filtered battery state
+constexpr unsigned long BATT_SAMPLE_INTERVAL = 2000; // ms between background ADC readings (battery.h)
+constexpr uint64_t LOW_BAT_SLEEP_INTERVAL = 2; // Minutes between battery checks while charging
+constexpr uint8_t BATT_WARN_PERCENT = 10; // the status light pulses red at or below this charge
 extern unsigned long lastBattCheck;
 
 // Peripheral checking
 extern bool dfplayerOK;
 extern bool nfcOK;
-extern unsigned long lastPeripheralCheck;
-extern const unsigned long CHECK_INTERVAL;
+constexpr unsigned long CHECK_INTERVAL = 10000; // ms between checks of a healthy peripheral (health.h)
+constexpr unsigned long NFC_SILENCE_TIMEOUT = 10000; // ms without a tag read before the idle PN532 is probed
+constexpr unsigned long HEALTH_PROBE_TIMEOUT = 1000; // ms a probe has to be answered
+constexpr uint8_t HEALTH_PROBES = 2; // unanswered probes in a row before reconnecting
+constexpr unsigned long HEALTH_BACKOFF_MIN = 1000; // ms after the first failed reconnect, doubling...
+constexpr unsigned long HEALTH_BACKOFF_MAX = 30000; // ...up to this
+constexpr uint8_t HEALTH_ATTEMPTS_BEFORE_FAILED = 4; // failed reconnects before a peripheral counts as failed
+constexpr unsigned long DFPLAYER_SERVICE_INTERVAL = 5; // ms between UART queue services
+constexpr unsigned long DFPLAYER_SILENCE_TIMEOUT = 30000; // ms without any sign of life before the module is pinged
+constexpr unsigned long NFC_BOOT_TIMEOUT = 1000; // ms the PN532 gets to answer at boot before polling starts without it (boot.h)
+constexpr unsigned long NFC_BOOT_RETRY_INTERVAL = 50; // ms between firmware probes while it hasn't
+
+// Playback tracking (playback.h)
+constexpr unsigned long PLAYBACK_SETTLE_MS = 300; // ACKed play with BUSY already low: counts as started after this
+constexpr unsigned long PLAYBACK_START_TIMEOUT = 2000; // ACKed play whose BUSY never went low: gave up
+constexpr unsigned long CHIME_MAX_MS = 5000; // a chime is cut off here if its end went unnoticed
+
+// Scheduler reporting
+constexpr unsigned long LOOP_STATS_INTERVAL = 60000; // print per-task CPU and worst-case latency every minute
+constexpr unsigned long CONSOLE_POLL_INTERVAL = 50; // ms between checks for serial commands
+constexpr unsigned long STATUS_LIGHT_INTERVAL = 50; // ms between status light pattern checks against the box state
+
+// Tasks (app_tasks.h)
+constexpr bool APP_TASKS_RTOS = true; // false runs the audio, UI and NFC schedulers in turn from loop()
+
+// Resume points (resume.h)
+constexpr unsigned long RESUME_SAVE_INTERVAL = 300000; // ms between flash writes of changed resume points (5 min)
+
+// Deferred logging (log.h)
+constexpr uint8_t LOG_DRAIN_PER_IDLE = 8; // log lines printed per idle pass before the CPU may sleep
+
+// Power management (power.h)
+constexpr bool LIGHT_SLEEP_ENABLED = true; // false keeps the USB console alive for debugging
+constexpr unsigned long LIGHT_SLEEP_MIN_MS = 20; // shorter gaps aren't worth the sleep entry/exit
+
+// Telemetry (telemetry.h); broker and Wi-Fi credentials are in secrets.h
+constexpr bool TELEMETRY_ENABLED = true;
+constexpr const char *TELEMETRY_TOPIC = "musicbox/telemetry";
+constexpr unsigned long TELEMETRY_INTERVAL = 900000; // ms between upload bursts (15 min)
+constexpr unsigned long TELEMETRY_CONNECT_TIMEOUT = 10000; // ms to get Wi-Fi + MQTT up before giving up
+constexpr unsigned long TELEMETRY_CHECK_INTERVAL = 1000; // ms between checks for an early upload
+
+
+// ======== Timing checks ========
+// A tag is only dropped after a presence check has missed it, and one
+// missed check alone doesn't stop a record. The last check before the
+// removal can be up to one interval old, so taking a record off stops it
+// within debounce + interval.
+static_assert(HEALTH_BACKOFF_MIN <= HEALTH_BACKOFF_MAX, "the reconnect backoff doubles up to HEALTH_BACKOFF_MAX");
+static_assert(TAG_REMOVAL_DEBOUNCE >= 2 * NFC_PRESENCE_INTERVAL, "TAG_REMOVAL_DEBOUNCE must span two presence checks");
+static_assert(TAG_REMOVAL_DEBOUNCE + NFC_PRESENCE_INTERVAL <= 400, "removal-to-stop should stay under 400 ms");
+static_assert(NFC_PRESENCE_INTERVAL <= NFC_POLL_FAST_INTERVAL && NFC_POLL_FAST_INTERVAL <= nfcInterval,
+              "NFC poll intervals must rise: presence <= fast <= idle");
+static_assert(NFC_POLL_BACKOFF > 1.0f, "the idle poll must back off");
+static_assert(NFC_REARM_BACKOFF < nfcInterval, "a failed IRQ arm is retried sooner than the idle poll");
+static_assert(NFC_POLL_ACTIVATION_RETRIES < 0xFF, "0xFF retries forever: a one-shot poll would wait out its timeout");
+static_assert(DEBOUNCE_TIME < LONG_PRESS_TIME, "a long press must outlast the debounce");
+static_assert(BUTTON_SCAN_INTERVAL < REPEAT_INTERVAL, "held buttons are checked faster than they repeat");
+static_assert(BATT_SAMPLE_INTERVAL < Batt_Check_Interval, "the battery filter needs several samples per check");
+static_assert(TELEMETRY_CHECK_INTERVAL < TELEMETRY_INTERVAL, "early uploads are checked between bursts");
 
 
 #endif // CONFIG_H
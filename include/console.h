@@ -0,0 +1,10 @@
+// console.h - line commands on the USB serial port (type "help")
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+// Scheduled every CONSOLE_POLL_INTERVAL: collect typed characters and run
+// complete lines. Never waits for input.
+void pollConsole();
+
+#endif // CONSOLE_H
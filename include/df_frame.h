@@ -0,0 +1,63 @@
+// df_frame.h - DFPlayer Mini serial frame codec (no Arduino dependencies)
+//
+// Every frame is 10 bytes:
+//   0x7E 0xFF 0x06 CMD FEEDBACK PARAM_H PARAM_L CHK_H CHK_L 0xEF
+// where CHK = -(0xFF + 0x06 + CMD + FEEDBACK + PARAM_H + PARAM_L) as 16 bits.
+
+#ifndef DF_FRAME_H
+#define DF_FRAME_H
+
+#include <stdint.h>
+
+const uint8_t DF_FRAME_LEN = 10;
+
+// Commands (host -> module)
+const uint8_t DF_CMD_NEXT          = 0x01;
+const uint8_t DF_CMD_PREVIOUS      = 0x02;
+const uint8_t DF_CMD_VOLUME        = 0x06;
+const uint8_t DF_CMD_RESET         = 0x0C;
+const uint8_t DF_CMD_PLAY_FOLDER   = 0x0F; // param = folder << 8 | track
+const uint8_t DF_CMD_STOP          = 0x16;
+const uint8_t DF_CMD_LOOP_FOLDER   = 0x17;
+const uint8_t DF_CMD_RANDOM_ALL    = 0x18;
+
+// Queries (answered with a frame carrying the same command byte)
+const uint8_t DF_QUERY_VOLUME      = 0x43;
+const uint8_t DF_QUERY_SD_FILES    = 0x48;
+const uint8_t DF_QUERY_SD_TRACK    = 0x4C;
+const uint8_t DF_QUERY_FOLDER_FILES = 0x4E;
+
+// Unsolicited frames (module -> host)
+const uint8_t DF_EVT_CARD_INSERTED = 0x3A;
+const uint8_t DF_EVT_CARD_REMOVED  = 0x3B;
+const uint8_t DF_EVT_TRACK_FINISHED = 0x3D;
+const uint8_t DF_EVT_ONLINE        = 0x3F; // sent after power-up/reset, param = online devices
+const uint8_t DF_EVT_ERROR         = 0x40;
+const uint8_t DF_EVT_ACK           = 0x41;
+
+struct DFFrame {
+  uint8_t cmd;
+  bool feedback;
+  uint16_t param;
+};
+
+uint16_t dfChecksum(const uint8_t *frame);
+void dfEncodeFrame(const DFFrame &frame, uint8_t out[DF_FRAME_LEN]);
+
+// Byte-at-a-time decoder: resynchronises on the 0x7E start byte and drops
+// frames with a bad checksum or end byte.
+class DFFrameDecoder {
+public:
+  // Returns true when `b` completed a valid frame, which is written to `out`.
+  bool push(uint8_t b, DFFrame &out);
+  void reset() { pos = 0; }
+
+  uint32_t checksumErrors = 0;
+  uint32_t framingErrors = 0;
+
+private:
+  uint8_t buf[DF_FRAME_LEN] = {};
+  uint8_t pos = 0;
+};
+
+#endif // DF_FRAME_H
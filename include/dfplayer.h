@@ -0,0 +1,113 @@
+// dfplayer.h - event-driven DFPlayer Mini driver
+//
+// Commands are queued and return immediately. One command is on the wire at a
+// time; it completes on the module's ACK (or query answer), an error frame, or
+// its timeout. Received bytes are decoded from the UART receive event and handed
+// to the main loop through a small frame ring, so service() never waits on the line.
+
+#ifndef DFPLAYER_H
+#define DFPLAYER_H
+
+#include <Arduino.h>
+#include "df_frame.h"
+#include "hal.h"
+
+// Completion callback for queued commands. `ok` is false on timeout or an
+// error frame; `value` is the query answer (or the error code).
+typedef void (*DFResponseFn)(uint8_t cmd, bool ok, uint16_t value);
+
+// Unsolicited frames: track finished, card inserted/removed, online, error
+typedef void (*DFEventFn)(uint8_t event, uint16_t param);
+
+class DFPlayer {
+public:
+  static const uint8_t TX_QUEUE_SIZE = 8;
+  static const uint8_t RX_QUEUE_SIZE = 8;
+  static const uint16_t DEFAULT_TIMEOUT_MS = 500;
+  static const uint16_t RESET_TIMEOUT_MS = 3000;
+
+  // Attach to the UART (already begun) and reset the module. Returns immediately;
+  // online() turns true once the module reports in. `onOnline` gets the reset's
+  // outcome: ok when the module reported in, not ok after RESET_TIMEOUT_MS.
+  void begin(SerialPort &port, DFResponseFn onOnline = nullptr);
+  // Attach without a reset, to a module known to be up (it stayed powered
+  // while the ESP32 was in deep sleep)
+  void resume(SerialPort &port);
+
+  // Fire-and-forget commands. Each returns false if the TX queue is full.
+  // `cb`, if given, runs when the module ACKs (or the command fails).
+  bool volume(uint8_t vol, DFResponseFn cb = nullptr);
+  bool playFolder(uint8_t folder, uint8_t track, DFResponseFn cb = nullptr);
+  bool loopFolder(uint8_t folder, DFResponseFn cb = nullptr);
+  bool stop();
+  bool next();
+  bool previous();
+  bool randomAll();
+  bool reset();
+
+  // Queries: the answer arrives through `cb`
+  bool queryVolume(DFResponseFn cb);
+  bool queryFolderFileCount(uint8_t folder, DFResponseFn cb);
+  bool querySdFileCount(DFResponseFn cb);
+
+  bool send(uint8_t cmd, uint16_t param, DFResponseFn cb = nullptr,
+            uint16_t timeoutMs = DEFAULT_TIMEOUT_MS);
+
+  void onEvent(DFEventFn cb) { eventCb = cb; }
+
+  // Call often from the main loop: dispatches received frames, expires the
+  // in-flight command and puts the next one on the wire.
+  void service();
+
+  // Drain the UART into the frame ring. Runs from the UART receive event.
+  void pumpRx();
+
+  bool online() const { return isOnline; }
+  bool idle() const { return !inFlight && txHead == txTail; }
+  unsigned long lastRxMillis() const { return lastRx; }
+
+  // Timing of the command that completed last (valid inside its callback):
+  // µs spent queued behind other commands, and on the wire until answered
+  uint32_t lastQueueWaitUs() const { return lastQueueWait; }
+  uint32_t lastRoundTripUs() const { return lastRoundTrip; }
+
+  uint32_t timeouts = 0;
+  uint32_t errors = 0;
+  uint32_t txDropped = 0;
+  uint32_t rxDropped = 0;
+  DFFrameDecoder decoder;
+
+private:
+  struct Pending {
+    DFFrame frame;
+    DFResponseFn cb;
+    uint16_t timeoutMs;
+    uint32_t queuedUs;
+  };
+
+  void attach(SerialPort &serial);
+  void dispatch(const DFFrame &f);
+  void complete(bool ok, uint16_t value);
+
+  SerialPort *port = nullptr;
+  DFEventFn eventCb = nullptr;
+
+  Pending txQueue[TX_QUEUE_SIZE];
+  uint8_t txHead = 0, txTail = 0;
+
+  // Single producer (UART event task) / single consumer (service())
+  DFFrame rxQueue[RX_QUEUE_SIZE];
+  volatile uint8_t rxHead = 0, rxTail = 0;
+
+  Pending current;
+  bool inFlight = false;
+  unsigned long sentAt = 0;
+  uint32_t sentUs = 0;
+  uint32_t lastQueueWait = 0;
+  uint32_t lastRoundTrip = 0;
+
+  volatile unsigned long lastRx = 0;
+  bool isOnline = false;
+};
+
+#endif // DFPLAYER_H
@@ -0,0 +1,42 @@
+// folder_play.h - plays a record's folder one track at a time
+//
+// The DFPlayer can loop a folder (0x17), but only from its first track, and
+// its random mode (0x18) shuffles the whole SD card. So the box plays the
+// folder itself with playFolder(folder, track) and moves on when a track
+// ends (playback.h):
+//   - in order, from any track (the record's resume point, resume.h),
+//     wrapping around after the last one
+//   - shuffled, in a Fisher-Yates order drawn on every placement and starting
+//     at a random track. Once every track has played, a fresh order is drawn.
+//
+// The track count of each folder is kept in NVS. Shuffling needs it up front:
+// the first time, it asks the module once (query 0x4E). Playing in order
+// learns it for free when the track after the last one fails. The stored
+// counts are tied to the card through its total file count (query 0x48,
+// asked once per boot and on card insertion); a different card clears them.
+//
+// Audio task only (app_tasks.h).
+
+#ifndef FOLDER_PLAY_H
+#define FOLDER_PLAY_H
+
+#include <Arduino.h>
+#include "dfplayer.h"
+
+void folderPlayBegin();        // load the cached counts, ask the card for its signature
+void folderPlayCardChanged();  // SD card inserted: check the signature again
+
+// Play `folder` from `firstTrack`, or shuffled (`firstTrack` ignored).
+// `onStarted` gets the first track's ACK; a shuffled folder whose count is
+// unknown waits for one 0x4E query first.
+void folderPlayStart(uint8_t folder, uint8_t firstTrack, bool shuffled, DFResponseFn onStarted);
+void folderPlayStop();
+bool folderPlayActive();
+uint8_t folderPlayTrack();     // the track playing now, 0 if none
+
+void folderPlayNext();
+void folderPlayPrevious();
+
+void folderPlayPrintStats();
+
+#endif // FOLDER_PLAY_H
@@ -0,0 +1,97 @@
+// hal.h - thin interfaces between the firmware logic and its peripherals
+//
+// The ESP32 implementations (src/hal_esp32.cpp) wrap the same libraries as
+// before: Adafruit_PN532, HardwareSerial, Preferences, WiFi and PubSubClient. The `native`
+// PlatformIO environment swaps in simulated ones from lib/sim instead.
+//
+// Clock, GPIO and ADC go through the Arduino core API (millis(), digitalRead(),
+// analogReadMilliVolts()...); on the host, lib/sim provides that API on top of
+// a virtual clock and simulated pins.
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---- NFC reader (PN532 + NTAG2xx tags) ----
+class NfcReader {
+public:
+  virtual ~NfcReader() {}
+
+  virtual bool begin() = 0;
+  virtual uint32_t getFirmwareVersion() = 0;   // 0 if the reader didn't answer
+  virtual bool SAMConfig() = 0;
+  virtual bool setPassiveActivationRetries(uint8_t maxRetries) = 0;
+
+  // ISO14443A target detection: blocking with a timeout...
+  virtual bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLen, uint16_t timeoutMs) = 0;
+  // ...or split in two around the IRQ line
+  virtual bool startPassiveTargetIDDetection() = 0;
+  virtual bool readDetectedPassiveTargetID(uint8_t *uid, uint8_t *uidLen) = 0;
+
+  // NTAG READ of the selected target: one page (4 bytes) or a whole block of 4 pages (16 bytes)
+  virtual bool readPage(uint8_t page, uint8_t *buf) = 0;
+  virtual bool readPages(uint8_t page, uint8_t *buf) = 0;
+
+  // PowerDown between polls: RF field off, the chip wakes on SPI. Every other
+  // call wakes the reader first (and restores its configuration), so callers
+  // never have to.
+  virtual bool powerDown() = 0;
+  virtual bool poweredDown() const = 0;
+};
+
+// ---- Byte stream to the DFPlayer ----
+typedef void (*SerialRxFn)(void *ctx);
+
+class SerialPort {
+public:
+  virtual ~SerialPort() {}
+
+  virtual void begin() = 0;   // (re)open at the module's baud rate and pins
+  virtual int available() = 0;
+  virtual int read() = 0;     // -1 if nothing is waiting
+  virtual size_t write(const uint8_t *buf, size_t len) = 0;
+
+  // Called from the receive event (UART event task on the ESP32) when bytes arrive
+  virtual void onReceive(SerialRxFn fn, void *ctx) = 0;
+};
+
+// ---- Persistent key/value storage (NVS on the ESP32) ----
+// Mirrors the subset of Preferences the firmware uses.
+class Storage {
+public:
+  virtual ~Storage() {}
+
+  virtual bool begin(const char *ns, bool readOnly) = 0;
+  virtual void end() = 0;
+
+  virtual uint32_t getUInt(const char *key, uint32_t defaultValue) = 0;
+  virtual size_t putUInt(const char *key, uint32_t value) = 0;
+  virtual size_t getBytesLength(const char *key) = 0;
+  virtual size_t getBytes(const char *key, void *buf, size_t len) = 0;
+  virtual size_t putBytes(const char *key, const void *buf, size_t len) = 0;
+};
+
+// ---- Telemetry uplink (Wi-Fi + MQTT) ----
+// Every call returns promptly: connect() only starts the association, poll()
+// advances it a step at a time, so the loop keeps running while the radio
+// comes up.
+enum LinkState : uint8_t {
+  LINK_OFF,
+  LINK_CONNECTING,
+  LINK_UP,        // broker session open, publish() may be called
+  LINK_FAILED,    // gave up this attempt (no network, broker refused)
+};
+
+class TelemetryLink {
+public:
+  virtual ~TelemetryLink() {}
+
+  virtual void connect() = 0;      // radio on, start joining the network
+  virtual LinkState poll() = 0;
+  virtual bool publish(const char *topic, const char *payload, size_t len) = 0;
+  virtual void disconnect() = 0;   // close the session, radio off
+};
+
+#endif // HAL_H
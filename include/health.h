@@ -0,0 +1,88 @@
+// health.h - one supervisor per peripheral (DFPlayer, PN532)
+//
+//   HEALTHY     normal traffic (frames, BUSY edges, tag reads) shows it's
+//               alive. Only after `silenceMs` without any, and only when the
+//               probe gets in nobody's way, is it asked directly.
+//   SUSPECT     a probe went unanswered; it's probed again. Still presumed
+//               working, so the status light doesn't flicker on one miss.
+//   RECOVERING  HEALTH_PROBES probes missed (or the boot bring-up failed):
+//               reconnect attempts run as a job, spaced by an exponential
+//               backoff from HEALTH_BACKOFF_MIN to HEALTH_BACKOFF_MAX
+//   FAILED      HEALTH_ATTEMPTS_BEFORE_FAILED attempts in a row failed. It
+//               keeps retrying at the backoff, so a reseated module comes back.
+//
+// A successful attempt restores what the user had (volume, the record
+// playing) through `restore`. Transitions and recovery times are counted.
+//
+// Each monitor belongs to the task that talks to its peripheral and drives
+// that task's health task: check() sets the task's next run itself.
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+enum HealthState : uint8_t {
+  HEALTH_HEALTHY,
+  HEALTH_SUSPECT,
+  HEALTH_RECOVERING,
+  HEALTH_FAILED,
+  HEALTH_STATE_COUNT
+};
+
+struct HealthHooks {
+  unsigned long (*lastHeardMs)(); // newest sign of life from normal traffic
+  bool (*canProbe)();             // a probe now wouldn't get in the way
+  void (*probe)();                // its answer shows up in lastHeardMs()
+  JobStep reconnect;              // one attempt; ends by calling attemptDone()
+  void (*restore)();              // after a recovery (optional)
+};
+
+class HealthMonitor {
+public:
+  void begin(const char *name, Scheduler &sched, int taskId, const HealthHooks &hooks, unsigned long silenceMs);
+  void booted(bool ok);        // the boot bring-up's outcome (boot.h)
+  void check();                // from the health task
+  void attemptDone(bool ok);   // from the reconnect job
+
+  HealthState state() const { return st; }
+  bool ok() const { return st == HEALTH_HEALTHY || st == HEALTH_SUSPECT; }
+
+  void printStats();
+
+private:
+  void enter(HealthState next);
+  void schedule(unsigned long ms);
+  bool heardSince(unsigned long t) const;
+  bool resolveProbe();
+  void startRecovery(bool attemptNow);
+  void attempt();
+
+  const char *name = "?";
+  Scheduler *sched = nullptr;
+  int taskId = -1;
+  HealthHooks hooks = {};
+  unsigned long silenceMs = 0;
+
+  HealthState st = HEALTH_HEALTHY;
+  bool probing = false;
+  unsigned long probeAt = 0;
+  uint8_t missed = 0;            // unanswered probes in a row
+  bool attempting = false;
+  uint8_t attempts = 0;          // in this recovery
+  unsigned long backoff = 0;
+  unsigned long recoveryStart = 0;
+
+  uint32_t entered[HEALTH_STATE_COUNT] = {};
+  uint32_t probes = 0;
+  uint32_t attemptsTotal = 0;
+  uint32_t recoveries = 0;
+  unsigned long lastRecoveryMs = 0;
+  unsigned long worstRecoveryMs = 0;
+};
+
+extern HealthMonitor dfplayerHealth; // audio task
+extern HealthMonitor readerHealth;   // NFC task
+
+#endif // HEALTH_H
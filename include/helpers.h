@@ -5,36 +5,19 @@
 
 // ======== Library initialization ========
 #include <Arduino.h>
-#include <Adafruit_NeoPixel.h>
-#include <Adafruit_PN532.h>
+#include "dfplayer.h"
 #include "tag_parser.h"
 
 // ======== Function prototypes ======== //
 
 // All defined in helpers.cpp
 
-int readRFID();
-int readVolumeKnob();
-String readNdefTextFromTag();
-TagCommand parseTagPayload(const String& payload);
-bool readTagPage(uint8_t page, uint8_t *buf);
-float readBatVoltage();
+size_t readNdefTextFromTag(char *out, size_t outSize);
+bool readTagPages(uint8_t page, uint8_t *buf);
 void checkBatteryAndSleepIfLow();
-bool checkDFPlayerConnection();
-void checkPeripherals();
-void setStatusLight(uint8_t RedVal, uint8_t GreenVal, uint8_t BlueVal);
+void lowBatterySleep();
+void playChime(uint8_t track, DFResponseFn onStarted = nullptr); // ends with the clip (playback.h)
+void cancelChime();
 
 
-#pragma once
-
-enum ButtonAction {
-  BUTTON_NONE,
-  BUTTON_SHORT,
-  BUTTON_LONG,
-  BUTTON_REPEAT
-};
-
-ButtonAction checkButton(uint8_t pin);
-void handleButtonAction();
-
 #endif // HELPERS_H
\ No newline at end of file
@@ -0,0 +1,62 @@
+// latency.h - fixed-bucket latency histograms for the user-facing paths
+//
+// Timestamps come from micros(), which on the ESP32 core reads the esp_timer
+// (1 µs resolution, no rollover problems for differences under ~71 minutes).
+// End-to-end paths are opened at their first stage and closed by the
+// DFPlayer's ACK, i.e. when the module has accepted the command.
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <Arduino.h>
+
+enum LatencyMetric {
+  // End-to-end
+  LAT_PLACEMENT,    // tag detection started -> play command ACKed
+  LAT_REMOVAL,      // first missed poll -> removal chime ACKed (includes TAG_REMOVAL_DEBOUNCE)
+  LAT_BUTTON,       // button action seen by the scan -> volume command ACKed
+  LAT_LOOP,         // busy time of one task round (app_tasks.h)
+  LAT_PRESENCE,     // one presence check of the tag on the reader
+
+  // Stages of the placement path
+  LAT_DETECT,       // UID read (poll or IRQ response)
+  LAT_NDEF_READ,    // NDEF read from the tag
+  LAT_PARSE,        // payload parse
+  LAT_DF_QUEUE,     // command queued -> on the wire
+  LAT_DF_ACK,       // on the wire -> ACK
+
+  LAT_COUNT
+};
+
+class LatencyHistogram {
+public:
+  static const uint8_t BUCKETS = 16;
+
+  void record(uint32_t us);
+  void reset();
+  uint32_t percentileUs(uint8_t pct) const; // upper bound of the bucket holding it
+  void print(const char *name) const;
+
+  uint32_t count = 0;
+  uint32_t minUs = 0;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+  uint32_t buckets[BUCKETS] = {};
+};
+
+// Upper bounds of the buckets (1-2-5 steps from 100 µs to 5 s, then overflow)
+extern const uint32_t LATENCY_BUCKET_US[LatencyHistogram::BUCKETS];
+
+void latencyRecord(LatencyMetric m, uint32_t us);
+
+// Open a path at `startUs`, then close it when its last stage completes.
+// Reopening a path that is still open restarts it.
+void latencyBegin(LatencyMetric m, uint32_t startUs);
+void latencyEnd(LatencyMetric m);
+void latencyCancel(LatencyMetric m);
+bool latencyOpen(LatencyMetric m);
+
+void latencyPrint();
+void latencyReset();
+
+#endif // LATENCY_H
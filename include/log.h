@@ -0,0 +1,111 @@
+// log.h - deferred logging for the hot paths
+//
+// LOG_E / LOG_W / LOG_I / LOG_D("format", args...) neither format nor touch
+// the serial port. They copy the format string's address, a timestamp and the
+// arguments (one machine word each) into a fixed-size record in a lock-free
+// ring, which any task or ISR can write to. The records are formatted and
+// printed in idle time (appTasksLoop(), when every task is waiting), so a
+// tag event no longer waits on the USB serial port.
+//
+// Levels above LOG_LEVEL (build flag, default LOG_LEVEL_INFO) compile to
+// nothing; their arguments aren't even evaluated.
+//
+// Arguments: up to LOG_MAX_ARGS integers, chars, bools, floats, and strings
+// that outlive the record (literals, name tables). %s stores the pointer, so
+// never a stack buffer. No trailing newline: each record is one line.
+//
+// Records never leave the device in binary form. The format pointer that
+// identifies a record only means something to this firmware image, and the
+// box is only ever read over its own USB console, so the drain formats the
+// records on the device. That keeps a host decoder and a copy of the
+// matching ELF out of the loop.
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+static const uint8_t LOG_MAX_ARGS = 4;
+
+union LogArg {
+  uint32_t u;
+  int32_t i;
+  float f;
+  const char *s;
+};
+
+// ---- Argument packing ----
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, LogArg>::type
+logArg(T v) {
+  static_assert(sizeof(T) <= sizeof(long), "64-bit log arguments aren't supported");
+  LogArg a = {};
+  if (std::is_signed<T>::value) a.i = (int32_t)v;
+  else a.u = (uint32_t)v;
+  return a;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, LogArg>::type
+logArg(T v) {
+  LogArg a = {};
+  a.f = (float)v;
+  return a;
+}
+
+inline LogArg logArg(const char *v) {
+  LogArg a = {};
+  a.s = v;
+  return a;
+}
+
+bool logPush(uint8_t level, const char *fmt, const LogArg *args, uint8_t argc);
+
+template <typename... Args>
+inline void logWrite(uint8_t level, const char *fmt, Args... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+  const LogArg packed[sizeof...(Args) + 1] = {logArg(args)...};
+  logPush(level, fmt, packed, sizeof...(Args));
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) logWrite(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) logWrite(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) logWrite(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) logWrite(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) do {} while (0)
+#endif
+
+// Format and print up to `maxRecords` queued records; false once the ring is empty
+bool logDrain(uint8_t maxRecords);
+void logFlush(); // everything, e.g. before deep sleep
+void logPrintStats();
+
+#endif // LOG_H
@@ -0,0 +1,101 @@
+// ndef.h - streaming NDEF decoder for NTAG user memory (no Arduino dependencies)
+//
+// Feed user memory (from page 4) in whatever chunks the reader returns; the
+// decoder walks the TLVs and the NDEF records as bytes arrive and reports
+// DONE as soon as the wanted record is complete, so the caller can stop
+// reading the tag there.
+//
+// Handled:
+//   - TLVs with 1-byte or 3-byte (0xFF LL LL) lengths; NULL, lock/memory
+//     control and proprietary TLVs are skipped
+//   - multi-record messages (MB/ME), short and long records, ID fields
+//   - chunked records (CF): the payload is reassembled across chunks
+//   - Text (status/language stripped, UTF-16 reduced to ASCII), URI (prefix
+//     code expanded) and MIME records; everything else is skipped unbuffered
+
+#ifndef NDEF_H
+#define NDEF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum NdefRecordType : uint8_t {
+  NDEF_RECORD_NONE = 0,
+  NDEF_RECORD_TEXT = 1 << 0,
+  NDEF_RECORD_URI  = 1 << 1,
+  NDEF_RECORD_MIME = 1 << 2,
+};
+
+enum NdefStatus : uint8_t {
+  NDEF_MORE,       // keep feeding
+  NDEF_DONE,       // wanted record complete, see record()
+  NDEF_NOT_FOUND,  // message (or memory) ended without a wanted record
+  NDEF_ERROR,      // malformed TLV/record
+};
+
+struct NdefRecord {
+  NdefRecordType type;
+  char mimeType[32];  // MIME records: the media type (truncated)
+  char lang[8];       // Text records: the language code (truncated)
+  size_t length;      // bytes written to the output buffer
+  bool truncated;     // the payload didn't fit the output buffer
+};
+
+class NdefDecoder {
+public:
+  // `want` is a mask of NdefRecordType; the first matching record's content is
+  // written NUL-terminated to out[outSize].
+  void begin(char *out, size_t outSize, uint8_t want);
+
+  NdefStatus push(const uint8_t *data, size_t len);
+  NdefStatus status() const { return state; }
+  const NdefRecord &record() const { return rec; }
+
+  // User memory consumed so far; the caller needs no bytes beyond this
+  size_t consumed() const { return offset; }
+
+private:
+  enum Step : uint8_t {
+    TLV_TAG, TLV_LEN, TLV_LEN_EXT_HI, TLV_LEN_EXT_LO, TLV_SKIP,
+    REC_HEADER, REC_TYPE_LEN, REC_PAYLOAD_LEN, REC_ID_LEN, REC_TYPE, REC_ID, REC_PAYLOAD,
+  };
+
+  NdefStatus feed(uint8_t b);
+  NdefStatus startTlvValue();
+  NdefStatus nextField();        // move past fields that are empty
+  NdefStatus endRecord();
+  void typeDone();
+  void payloadByte(uint8_t b);
+  void emit(char c);
+  void emitString(const char *s);
+
+  char *out = nullptr;
+  size_t outSize = 0;
+  uint8_t want = 0;
+  NdefRecord rec = {};
+  NdefStatus state = NDEF_MORE;
+  size_t offset = 0;
+
+  Step step = TLV_TAG;
+  uint8_t tlvTag = 0;
+  uint16_t tlvLeft = 0;          // bytes left in the current TLV value
+
+  uint8_t header = 0;
+  uint8_t typeLen = 0;
+  uint8_t idLen = 0;
+  uint32_t payloadLen = 0;
+  uint32_t fieldLeft = 0;        // bytes left in the current record field
+  uint8_t lenBytes = 0;          // long-record payload length bytes seen
+  char type[32] = {};
+  uint8_t typeHave = 0;
+
+  bool capturing = false;        // current record (or chunk series) is the wanted one
+  bool chunked = false;          // inside a CF chunk series
+  uint32_t payloadPos = 0;       // position in the (reassembled) payload
+  uint8_t langLen = 0;
+  bool utf16 = false;
+  bool utf16Le = false;
+  uint8_t utf16First = 0;
+};
+
+#endif // NDEF_H
@@ -0,0 +1,35 @@
+// nfc_detect.h - interrupt-driven tag arrival detection on the PN532 IRQ line
+//
+// While no tag is present the PN532 is left running InListPassiveTarget with
+// unlimited retries. It pulls IRQ low once a tag enters the field, the ISR posts
+// that to the main loop, and the UID is collected with a single read.
+// Boards without the IRQ wire (NFC_IRQ_pin < 0) keep the timed readPassiveTargetID() poll.
+//
+// The retry count is a PN532 setting, not a per-command one, so every one-shot
+// readPassiveTargetID() (presence checks, polls) relies on it being put back to
+// NFC_POLL_ACTIVATION_RETRIES: done when a detection completes or is disarmed,
+// and by nfcSetPollRetries() after a reader (re)start, which defaults to forever.
+
+#ifndef NFC_DETECT_H
+#define NFC_DETECT_H
+
+#include <Arduino.h>
+
+void nfcDetectBegin();
+bool nfcIrqWired();
+void nfcSetPollRetries(); // after SAMConfig on every bring-up / reconnect
+
+// Start a detection; rate-limited after failures so a missing reader can't stall the loop
+bool nfcArmDetection();
+bool nfcDetectArmed();
+
+// Any other PN532 command aborts a pending detection: call this before sending one
+void nfcDisarm();
+
+// True once when an armed detection has completed and the UID was read
+bool nfcTagDetected(uint8_t *uid, uint8_t *uidLen);
+
+// micros() when the IRQ fired for the last detection (start of the placement path)
+uint32_t nfcDetectedAtUs();
+
+#endif // NFC_DETECT_H
@@ -0,0 +1,22 @@
+// nfc_poll.h - adaptive tag poll cadence
+//
+// Without the IRQ wire the box has to poll for tags. Right after a removal (or
+// at boot) another record is likely, so polls come every NFC_POLL_FAST_INTERVAL;
+// once NFC_POLL_FAST_WINDOW has passed, each empty poll stretches the interval
+// by NFC_POLL_BACKOFF up to nfcInterval. Between these polls the PN532 is
+// powered down. While a tag plays, its presence is checked every
+// NFC_PRESENCE_INTERVAL with a single READ of the tag, which stays selected
+// (and the reader awake) until it is taken off (nfc_task.cpp).
+
+#ifndef NFC_POLL_H
+#define NFC_POLL_H
+
+#include <Arduino.h>
+
+// Open the fast window (boot, tag removed)
+void nfcPollBurst();
+
+// Interval to the next poll, given the outcome of this one
+unsigned long nfcPollNextInterval(bool tagPresent);
+
+#endif // NFC_POLL_H
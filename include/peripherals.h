@@ -2,15 +2,19 @@
 #define PERIPHERALS_H
 
 // Forward declarations only - include concrete headers in .cpp files that need them
-class Adafruit_NeoPixel;
-class DFRobotDFPlayerMini;
-class HardwareSerial;
-class Adafruit_PN532;
+class DFPlayer;
+class SerialPort;
+class NfcReader;
+class Storage;
+class TelemetryLink;
 
 // Peripherals defined in src/config.cpp
-extern Adafruit_NeoPixel StatusLight;
-extern DFRobotDFPlayerMini player;
-extern HardwareSerial MP3Serial; // using HardwareSerial for ESP32 hardware UART
-extern Adafruit_PN532 nfc;
+extern DFPlayer player; // in-tree async driver, see dfplayer.h
+
+// HAL instances (hal.h), defined in src/hal_esp32.cpp or lib/sim for the host build
+extern SerialPort &MP3Serial; // ESP32 hardware UART 1 to the DFPlayer
+extern NfcReader &nfc;
+extern Storage &storage;
+extern TelemetryLink &telemetryLink; // Wi-Fi + MQTT to the broker in secrets.h
 
 #endif // PERIPHERALS_H
@@ -0,0 +1,61 @@
+// playback.h - what the DFPlayer is actually doing
+//
+// Play commands go through here instead of straight to the driver, so the box
+// knows whether audio is coming out and when it ends, without asking the
+// module. Two sources feed the state:
+//   - the BUSY line (DF_BUSY_pin, low while audio plays), whose edges an
+//     interrupt timestamps into a ring the audio task replays, like the
+//     buttons (buttons.h)
+//   - the frames the module sends anyway: the play command's ACK, track
+//     finished (0x3D, sent twice), card removed, online after a reset
+//
+// A play is STARTING from the command until the audio runs: with BUSY, until
+// the line falls (or PLAYBACK_SETTLE_MS after the ACK if it never rose);
+// without it, until the ACK. Only a PLAYING track can finish, so the
+// duplicate finish frame and the BUSY blip of a track being replaced never
+// count twice. A finished track calls the `onFinished` given with its play
+// command: the next track for a record (folder_play.h), the end of a chime.
+//
+// Every frame and every BUSY edge is also a sign of life, and a BUSY line
+// held low is one too: the DFPlayer's supervisor (health.h) only pings it once
+// all of these have been quiet for DFPLAYER_SILENCE_TIMEOUT.
+//
+// With BUSY wired a playing record no longer keeps the CPU out of light
+// sleep: the line rising at the end of the track wakes it (power.cpp).
+//
+// Audio task only (app_tasks.h), apart from the BUSY interrupt.
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <Arduino.h>
+#include "dfplayer.h"
+
+enum PlaybackState : uint8_t {
+  PLAYBACK_STOPPED,
+  PLAYBACK_STARTING,
+  PLAYBACK_PLAYING
+};
+
+typedef void (*PlaybackDoneFn)();
+
+void playbackBegin();   // attach the BUSY interrupt, if wired
+void playbackReset();   // the driver was restarted: outstanding plays are gone
+
+// `onStarted` gets the command's ACK (as with the driver); `onFinished` runs
+// once when the track has played to its end
+bool playbackPlayFolder(uint8_t folder, uint8_t track, DFResponseFn onStarted, PlaybackDoneFn onFinished);
+bool playbackLoopFolder(uint8_t folder, DFResponseFn onStarted); // the module moves on by itself
+void playbackStop();
+
+void playbackFrame(uint8_t event, uint16_t param); // unsolicited frames (DFEventFn)
+void playbackService(); // replay BUSY edges, time out a start that never came
+void playbackResync();  // after light sleep, which stops the edge interrupt
+
+PlaybackState playbackState();
+bool playbackWakeOnEnd(); // playing with BUSY wired: its rising level can wake the CPU
+unsigned long playbackLastHeardMs();
+
+void playbackPrintStats();
+
+#endif // PLAYBACK_H
@@ -0,0 +1,32 @@
+// power.h - light sleep between scheduled events
+//
+// Installed as loop()'s idle handler (app_tasks.h). When no task has anything
+// due and no veto objects, the ESP32 enters light sleep until the next
+// non-sleepable deadline; the buttons (and the PN532 IRQ, when wired) wake it
+// early. Otherwise it falls back to a short delay() as before.
+//
+// Light sleep stops the UARTs: a frame from the DFPlayer arriving meanwhile is
+// lost. Hence the vetoes while a command is in flight or a record is playing.
+// The USB serial console also drops out while asleep; set LIGHT_SLEEP_ENABLED
+// to false when debugging over USB.
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// Returns true to keep the CPU awake right now
+typedef bool (*SleepVetoFn)();
+
+void powerBegin(); // wake sources + idle handler
+bool powerAddVeto(const char *name, SleepVetoFn fn);
+
+// Idle handler, called when every task is waiting
+void powerIdle(unsigned long msToNext);
+
+// Time per power state since the last reset: running tasks, idling awake
+// (and which veto kept it awake), light sleep
+void powerPrintStats();
+void powerResetStats();
+
+#endif // POWER_H
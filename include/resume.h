@@ -0,0 +1,49 @@
+// resume.h - per-record resume points (UID -> folder and track), kept in RAM
+// and persisted to NVS
+//
+// A record put back on the box carries on at the track it was taken off at.
+// Track changes only touch the RAM table; it reaches flash when a record is
+// removed and on a slow timer (RESUME_SAVE_INTERVAL), and then only if
+// something changed, so a long album costs a handful of writes, not one per
+// track. The DFPlayer can't seek within a track, so a resumed track restarts.
+
+#ifndef RESUME_H
+#define RESUME_H
+
+#include <Arduino.h>
+#include "uid_table.h"
+
+class ResumeTable {
+public:
+  static const uint8_t CAPACITY = 16;
+
+  ResumeTable();
+  void begin(); // load the persisted table
+
+  // The track to resume `folder` at for this record, 0 if none. A record
+  // rewritten to another folder starts over.
+  uint8_t lookup(const uint8_t *uid, uint8_t uidLen, uint8_t folder);
+
+  // Note where a record is at (RAM only). Track 1 is the default, so it
+  // clears the entry instead; evicts the least recently used entry when full.
+  void remember(const uint8_t *uid, uint8_t uidLen, uint8_t folder, uint8_t track);
+
+  void save(); // write the table to flash, if anything changed since the last write
+
+  uint32_t resumed = 0;
+  uint32_t writes = 0;
+  void printStats();
+
+private:
+  struct ResumePoint {
+    uint8_t folder;
+    uint8_t track;
+  };
+
+  UidTable<ResumePoint, CAPACITY> table;
+  bool dirty = false;
+};
+
+extern ResumeTable resumeTable;
+
+#endif // RESUME_H
@@ -0,0 +1,70 @@
+// scheduler.h - cooperative, non-blocking scheduler; each app task (app_tasks.h) runs one
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// A periodic task, called from Scheduler::tick() every `interval` ms.
+typedef void (*TaskFn)();
+
+// One stage of a resumable job. Called with its stage number (0, 1, 2...);
+// returns how many ms to wait before the next stage, or JOB_DONE when finished.
+// Use jobs instead of delay()/busy-waits: between stages the loop keeps running.
+typedef uint32_t (*JobStep)(uint8_t stage);
+const uint32_t JOB_DONE = 0xFFFFFFFFUL;
+
+class Scheduler {
+public:
+  static const uint8_t MAX_TASKS = 12;
+  static const uint8_t MAX_JOBS = 6;
+
+  // Register a periodic task. It first runs on the next tick. Returns its id, or -1 if full.
+  int addTask(const char* name, TaskFn fn, unsigned long intervalMs);
+  void setInterval(int id, unsigned long intervalMs);
+  void runSoon(int id);                 // make a task due on the next tick
+  void setEnabled(int id, bool enabled);
+  // A sleepable task's deadline doesn't hold off sleep: a wake source (GPIO,
+  // UART) stands in for it, and it runs as soon as the CPU wakes
+  void setSleepable(int id, bool sleepable);
+
+  // Start a resumable job at stage 0. A job that is already running is restarted.
+  bool startJob(JobStep step);
+  void cancelJob(JobStep step);
+  void runJobSoon(JobStep step);        // run a waiting job's next stage on the next tick
+  bool jobRunning(JobStep step) const;
+
+  // Run every task/job that is due and return. Waiting for the next deadline
+  // is up to the caller (app_tasks.cpp).
+  void tick();
+  unsigned long msUntilNext(bool skipSleepable = false) const;
+
+  void printStats();   // worst run per task since the last reset
+  void resetStats();
+
+private:
+  struct Task {
+    const char* name;
+    TaskFn fn;
+    unsigned long interval;
+    unsigned long nextRun;
+    uint32_t worstUs;
+    bool enabled;
+    bool sleepable;
+  };
+
+  struct Job {
+    JobStep step;
+    uint8_t stage;
+    unsigned long nextRun;
+  };
+
+  Task tasks[MAX_TASKS] = {};
+  Job jobs[MAX_JOBS] = {};
+  uint8_t taskCount = 0;
+};
+
+// Idle cap for loop() so a far-away deadline never hides a newly scheduled job for long
+const unsigned long SCHEDULER_MAX_IDLE_MS = 10;
+
+#endif // SCHEDULER_H
@@ -0,0 +1,67 @@
+// spsc_queue.h - lock-free single-producer / single-consumer ring
+//
+// One task pushes, one task pops; neither ever blocks or disables interrupts.
+// The producer only writes `head`, the consumer only writes `tail`, and the
+// release/acquire pair on each index publishes the slot contents with it.
+// Holds N - 1 items.
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint8_t N>
+class SpscQueue {
+public:
+  // Producer side. False (and counted) when full.
+  bool push(const T &item) {
+    uint8_t h = head.load(std::memory_order_relaxed);
+    uint8_t next = (h + 1) % N;
+    if (next == tail.load(std::memory_order_acquire)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots[h] = item;
+    head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T &out) {
+    if (!peek(0, out)) return false;
+    discard(1);
+    return true;
+  }
+
+  // Look at the i-th oldest item without taking it
+  bool peek(uint8_t i, T &out) const {
+    if (i >= size()) return false;
+    out = slots[(tail.load(std::memory_order_relaxed) + i) % N];
+    return true;
+  }
+
+  // Release the n oldest items (after peek())
+  void discard(uint8_t n) {
+    n = n < size() ? n : size();
+    tail.store((tail.load(std::memory_order_relaxed) + n) % N, std::memory_order_release);
+  }
+
+  // Either side; exact for the consumer, a lower bound for the producer
+  uint8_t size() const {
+    uint8_t h = head.load(std::memory_order_acquire);
+    uint8_t t = tail.load(std::memory_order_acquire);
+    return (h + N - t) % N;
+  }
+
+  static constexpr uint8_t capacity() { return N - 1; }
+  uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+  T slots[N];
+  std::atomic<uint8_t> head{0};
+  std::atomic<uint8_t> tail{0};
+  std::atomic<uint32_t> dropped{0};
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,42 @@
+// status_led.h - the RGB status light, driven by the LEDC peripheral
+//
+// The box state maps to a pattern: a short list of keyframes, each either a
+// jump to a colour or a ramp to it that the LEDC fade hardware runs on its
+// own. The CPU only steps in at keyframe boundaries (a UI-task job, whose
+// timer also wakes it from light sleep). The LEDC is clocked from RC_FAST,
+// which stays on in light sleep, so a solid colour or a ramp in progress
+// carries on while the CPU sleeps.
+//
+// Channels are only written when their duty changes, and a pattern is only
+// restarted when the state asks for a different one.
+
+#ifndef STATUS_LED_H
+#define STATUS_LED_H
+
+#include <Arduino.h>
+
+enum LedPatternId : uint8_t {
+  LED_OFF,
+  LED_BOOTING,          // dim yellow, until both peripherals have answered
+  LED_READY,            // green
+  LED_PLAYING,          // blue, breathing
+  LED_TAG_ERROR,        // red: tag without a usable record
+  LED_LOW_BATTERY,      // red pulse
+  LED_DFPLAYER_FAULT,   // cyan, blinks twice
+  LED_NFC_FAULT,        // magenta, blinks three times
+  LED_BOTH_FAULT,       // red, blinking
+  LED_PATTERN_COUNT
+};
+
+void statusLedBegin();
+
+// Solid colour right away, e.g. during boot before the tasks run
+void setStatusLight(uint8_t RedVal, uint8_t GreenVal, uint8_t BlueVal);
+
+// Select a pattern; false if it is already showing. On true, (re)start
+// statusLedJob on the UI scheduler to play it.
+bool statusLedShow(LedPatternId pattern);
+uint32_t statusLedJob(uint8_t stage);
+const char *statusLedPatternName(LedPatternId pattern);
+
+#endif // STATUS_LED_H
@@ -0,0 +1,42 @@
+// tag_cache.h - UID -> TagCommand cache, kept in RAM and persisted to NVS
+//
+// Known records start playing straight after the UID read, skipping the NDEF
+// read and parse. The NDEF is still verified in the background afterwards, and
+// a rewritten tag replaces its entry.
+
+#ifndef TAG_CACHE_H
+#define TAG_CACHE_H
+
+#include <Arduino.h>
+#include "tag_parser.h"
+#include "uid_table.h"
+
+class TagCache {
+public:
+  static const uint8_t CAPACITY = 16;
+
+  TagCache();
+  void begin(); // load the persisted table
+
+  // On a hit, copies the cached command into `out` and marks the entry as recently used
+  bool lookup(const uint8_t *uid, uint8_t uidLen, TagCommand &out);
+
+  // Insert or update; evicts the least recently used entry when full.
+  // Only writes to flash if the table actually changed.
+  void store(const uint8_t *uid, uint8_t uidLen, const TagCommand &cmd);
+  void invalidate(const uint8_t *uid, uint8_t uidLen);
+
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t stale = 0;   // background verify found a rewritten tag
+  void printStats();
+
+private:
+  UidTable<TagCommand, CAPACITY> table;
+};
+
+bool sameTagCommand(const TagCommand &a, const TagCommand &b);
+
+extern TagCache tagCache;
+
+#endif // TAG_CACHE_H
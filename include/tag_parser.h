@@ -1,8 +1,8 @@
 #ifndef TAG_PARSER_H
 #define TAG_PARSER_H
 
-#include <Arduino.h>
-#include <string>
+#include <stddef.h>
+#include <stdint.h>
 
 struct TagCommand {
   uint16_t folder;      // e.g., 07
@@ -13,10 +13,11 @@ struct TagCommand {
 };
 
 /**
- * Parse a tag payload string like "07 | volume 5 | shuffle"
- * Folder is required; track always defaults to 1.
- * Returns TagCommand with folder, volume, and shuffle flags.
+ * Parse a tag payload like "07 | volume 5 | shuffle" from a char view
+ * (`len` bytes, need not be NUL-terminated). Works in place: no heap, one pass.
+ * The first field is the folder (required); the rest are "keyword [number]"
+ * options, matched case-insensitively. Track always defaults to 1.
  */
-TagCommand parseTagPayload(const String& payload);
+TagCommand parseTagPayload(const char* payload, size_t len);
 
-#endif
\ No newline at end of file
+#endif
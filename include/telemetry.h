@@ -0,0 +1,49 @@
+// telemetry.h - event log uploaded to MQTT in short Wi-Fi bursts
+//
+// Events go into a fixed RAM ring (new ones are dropped when it's full). Only
+// the audio task records events; the uploads run in the UI task (app_tasks.h).
+// Every TELEMETRY_INTERVAL, or sooner once the ring is 3/4 full, a job brings
+// Wi-Fi up, publishes the ring as JSON batches to TELEMETRY_TOPIC and turns
+// the radio off again. Connecting is polled from the scheduler, never waited
+// on; if the network doesn't come up within TELEMETRY_CONNECT_TIMEOUT the
+// events stay queued for the next burst.
+//
+// One message looks like
+//   {"up":905123,"dropped":0,"events":[{"t":3051,"e":"play","uid":"04A1B2C3D4E5F6","folder":7,"vol":20}, ...]}
+// with "t" and "up" in ms since boot. To watch it against a local broker:
+//   mosquitto_sub -h <broker> -t 'musicbox/#' -v
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+enum TelemetryEventType : uint8_t {
+  TEL_BOOT,      // a: wakeup cause, b: battery mV
+  TEL_PLAY,      // uid, a: folder, b: volume
+  TEL_REMOVE,    // uid, a: seconds played
+  TEL_VOLUME,    // a: new volume
+  TEL_BATTERY,   // a: battery mV, b: percent
+  TEL_HEALTH,    // a: DFPlayer OK, b: PN532 OK
+  TEL_TYPE_COUNT
+};
+
+// Largest MQTT payload; a burst sends as many as the queue needs
+const size_t TELEMETRY_MAX_PAYLOAD = 768;
+
+void telemetryEvent(TelemetryEventType type, int16_t a = 0, int16_t b = 0);
+void telemetryTagEvent(TelemetryEventType type, const uint8_t *uid, uint8_t uidLen, int16_t a = 0, int16_t b = 0);
+
+// Scheduled every TELEMETRY_INTERVAL: start an upload burst if anything is queued
+void telemetryFlush();
+
+// Scheduled every second: start the early burst a nearly full ring asked for
+void telemetryService();
+
+// The radio is on (a burst is running); light sleep would drop the connection
+bool telemetryActive();
+
+// Events, bytes and radio-on time, in total and per hour of uptime
+void telemetryPrintStats();
+
+#endif // TELEMETRY_H
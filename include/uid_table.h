@@ -0,0 +1,109 @@
+// uid_table.h - fixed-size table keyed by tag UID, least recently used entry
+// evicted when full, persisted to NVS as one blob
+//
+// The storage under the tag cache (tag_cache.h) and the resume points
+// (resume.h). The blob is tagged with a layout version, so a firmware change
+// to the payload never misreads an old table; bump the owner's version when
+// the payload changes. When to save is up to the owner.
+
+#ifndef UID_TABLE_H
+#define UID_TABLE_H
+
+#include <Arduino.h>
+#include "hal.h"
+#include "peripherals.h"
+
+template <typename Payload, uint8_t CAPACITY>
+class UidTable {
+public:
+  struct Entry {
+    uint8_t uid[7];
+    uint8_t uidLen;     // 0 = empty slot
+    Payload value;
+    uint32_t lastUsed;
+  };
+
+  UidTable(const char *nvsNamespace, uint32_t layoutVersion)
+      : ns(nvsNamespace), version(layoutVersion) {}
+
+  // Load the persisted table; a missing or old-layout one leaves it empty.
+  // Returns the number of records loaded.
+  uint8_t load() {
+    storage.begin(ns, true);
+    bool ok = storage.getUInt(VERSION_KEY, 0) == version &&
+              storage.getBytesLength(ENTRIES_KEY) == sizeof(entries) &&
+              storage.getBytes(ENTRIES_KEY, entries, sizeof(entries)) == sizeof(entries);
+    storage.end();
+
+    if (!ok) {
+      memset(entries, 0, sizeof(entries));
+      return 0;
+    }
+
+    // Continue the LRU clock from the newest persisted entry
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+      if (!entries[i].uidLen) continue;
+      count++;
+      if (entries[i].lastUsed > useClock) useClock = entries[i].lastUsed;
+    }
+    return count;
+  }
+
+  void save() {
+    storage.begin(ns, false);
+    storage.putUInt(VERSION_KEY, version);
+    storage.putBytes(ENTRIES_KEY, entries, sizeof(entries));
+    storage.end();
+  }
+
+  // Slot holding this UID, -1 if none
+  int find(const uint8_t *uid, uint8_t uidLen) const {
+    if (!uidLen || uidLen > 7) return -1;
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+      if (entries[i].uidLen == uidLen && memcmp(entries[i].uid, uid, uidLen) == 0) return i;
+    }
+    return -1;
+  }
+
+  const Payload &at(int i) const { return entries[i].value; }
+
+  // Mark as recently used. LRU order only lives in RAM until the next save().
+  void touch(int i) { entries[i].lastUsed = ++useClock; }
+
+  // Insert or replace this UID's entry, taking an empty slot or evicting the
+  // least recently used one. Returns the slot, -1 for an invalid UID.
+  int put(const uint8_t *uid, uint8_t uidLen, const Payload &value) {
+    if (!uidLen || uidLen > 7) return -1;
+
+    int i = find(uid, uidLen);
+    if (i < 0) {
+      i = 0;
+      for (uint8_t j = 0; j < CAPACITY; j++) {
+        if (!entries[j].uidLen) { i = j; break; }
+        if (entries[j].lastUsed < entries[i].lastUsed) i = j;
+      }
+    }
+
+    Entry &e = entries[i];
+    memset(&e, 0, sizeof(e));
+    memcpy(e.uid, uid, uidLen);
+    e.uidLen = uidLen;
+    e.value = value;
+    e.lastUsed = ++useClock;
+    return i;
+  }
+
+  void erase(int i) { memset(&entries[i], 0, sizeof(entries[i])); }
+
+private:
+  static constexpr const char *ENTRIES_KEY = "entries";
+  static constexpr const char *VERSION_KEY = "version";
+
+  const char *ns;
+  uint32_t version;
+  Entry entries[CAPACITY] = {};
+  uint32_t useClock = 0;
+};
+
+#endif // UID_TABLE_H
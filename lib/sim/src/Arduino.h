@@ -0,0 +1,94 @@
+// Arduino core API for the host build. Time is virtual (see sim.h): delay()
+// advances it instead of sleeping, so a whole day of use runs in milliseconds.
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define HEX 16
+#define DEC 10
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+// ---- Clock ----
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ---- Random: a fixed seed, so every run of a script plays the same order ----
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// ---- GPIO / ADC / PWM ----
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void analogWrite(uint8_t pin, int value);
+
+typedef enum { LEDC_USE_APB_CLK, LEDC_USE_RC_FAST_CLK, LEDC_USE_XTAL_CLK } ledc_clk_cfg_t;
+bool ledcSetClockSource(ledc_clk_cfg_t source);
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+bool ledcFade(uint8_t pin, uint32_t startDuty, uint32_t targetDuty, int maxFadeTimeMs);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+// ---- USB serial: stdout, with input injected by the script ----
+class SimSerial {
+public:
+  void begin(unsigned long) {}
+  int available();
+  int read();
+
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *s);
+  size_t print(char c);
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + print("\n"); }
+  size_t println() { return print("\n"); }
+  void flush() { fflush(stdout); }
+  operator bool() const { return true; }
+};
+
+extern SimSerial Serial;
+
+#include "esp_sleep.h"
+
+#endif // SIM_ARDUINO_H
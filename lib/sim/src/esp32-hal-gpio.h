@@ -0,0 +1,2 @@
+// Host stand-in: the GPIO API is declared in the sim's Arduino.h
+#include "Arduino.h"
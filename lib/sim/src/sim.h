@@ -0,0 +1,92 @@
+// sim.h - control surface for the host simulation (native environment)
+//
+// The simulation runs setup() and then loop() against a virtual clock. A script
+// of timed events drives the simulated world. One event per line, '#' comments:
+//
+//   <ms> place <uid-hex> <text>      put a tag holding an NDEF Text record on the reader
+//   <ms> place-raw <uid-hex> <hex>   put a tag whose user memory (page 4 on) is these bytes
+//   <ms> place-noread <uid-hex>      put a tag that is not an NTAG/Ultralight: it refuses every READ
+//   <ms> remove                      take the tag off
+//   <ms> press <pin> / release <pin> drive a button (active low)
+//   <ms> battery <volts>             set the battery voltage
+//   <ms> nfc-fail / nfc-ok           unplug / replug the PN532
+//   <ms> dfplayer-fail / dfplayer-ok unplug / replug the DFPlayer
+//   <ms> wifi-fail / wifi-ok         take the Wi-Fi network out of / back into range
+//   <ms> serial <text>               type a line on the USB serial port
+//   <ms> end                         stop the simulation
+//
+// e.g. `500 place 04A1B2C3D4E5F6 07 | volume 5 | shuffle`
+//
+// Telemetry is printed; SIM_MQTT_BROKER=host[:port] also publishes it to a real
+// broker, e.g. a local mosquitto watched with `mosquitto_sub -t 'musicbox/#' -v`.
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---- Virtual clock ----
+uint64_t simNowUs();
+void simAdvanceUs(uint64_t us);   // runs script events and peripheral replies that fall due
+
+// ---- Pins ----
+void simSetPin(uint8_t pin, int level); // fires attached interrupts on matching edges
+int simGetPin(uint8_t pin);
+void simSetBatteryVolts(float volts);
+
+// ---- Script ----
+bool simLoadScript(const char *path); // nullptr loads the built-in demo script
+bool simFinished();
+void simRequestEnd();
+
+// ---- Peripherals ----
+struct SimTag {
+  uint8_t uid[7];
+  uint8_t uidLen;
+  uint8_t memory[888];  // user memory from page 4 (NTAG216 size)
+  size_t memoryLen;
+  bool refusesRead;     // not an NTAG/Ultralight (e.g. MIFARE Classic): READ always fails
+};
+
+void simPlaceTag(const SimTag &tag);
+void simRemoveTag();
+bool simBuildTextTag(const char *uidHex, const char *text, SimTag &out);
+void simSetNfcConnected(bool connected);
+void simSetNfcIrqPin(int pin); // mirror detection state on this pin (-1: none)
+uint32_t simNfcPageZeroReads();  // READs of page 0, i.e. presence checks (nfc_task.cpp)
+
+void simSetDFPlayerConnected(bool connected);
+void simSetDFPlayerBusyPin(int pin); // drive BUSY on this pin, low while playing (-1: none)
+void simDFPlayerDeliver();       // hand due reply bytes to the UART
+uint64_t simDFPlayerNextDueUs(); // UINT64_MAX if nothing is pending
+float simAudioSagVolts();        // battery sag while the DFPlayer plays
+
+void simSetWifiAvailable(bool available);
+uint32_t simMqttMessages();
+uint32_t simMqttBytes();
+
+uint64_t simLightSleepUs();       // total time spent in esp_light_sleep_start()
+uint32_t simLightSleeps();
+
+void simSerialInput(const char *line);
+void simPrintSummary();
+
+// ---- Costs charged to the virtual clock, roughly the real bus times ----
+const uint32_t SIM_NFC_DETECT_US = 8000;     // InListPassiveTarget with a tag present
+const uint32_t SIM_NFC_ATTEMPT_US = 3000;    // one InListPassiveTarget attempt with no tag in the field
+const uint32_t SIM_NFC_READ_US = 4000;       // one InDataExchange READ
+const uint32_t SIM_NFC_COMMAND_US = 2000;    // firmware version, SAMConfig, ...
+const uint32_t SIM_NFC_WAKE_US = 2000;       // SS held low out of PowerDown
+const uint32_t SIM_DF_REPLY_US = 25000;      // DFPlayer ACK / query answer latency
+const uint32_t SIM_DF_BOOT_US = 1200000;     // reset until the "online" frame
+const uint32_t SIM_TRACK_US = 180000000;     // every simulated track is 3 minutes...
+const uint32_t SIM_CHIME_US = 1800000;       // ...except the chimes in folder 01
+const uint8_t SIM_FOLDER_TRACKS = 12;        // every simulated folder holds 12 tracks
+const uint32_t SIM_WIFI_JOIN_US = 1500000;   // association + DHCP
+const uint32_t SIM_WIFI_SCAN_US = 4000000;   // until the scan reports no network
+const uint32_t SIM_MQTT_CONNECT_US = 60000;  // TCP + CONNECT/CONNACK on the LAN
+const uint32_t SIM_MQTT_PUBLISH_US = 5000;
+const float SIM_AUDIO_SAG_V = 0.10f;         // battery sag with the speaker at volume 30
+
+#endif // SIM_H
@@ -0,0 +1,303 @@
+// Arduino core API on top of the virtual clock and simulated pins
+#include <deque>
+#include "Arduino.h"
+#include "driver/gpio.h"
+#include "sim.h"
+
+SimSerial Serial;
+
+static const uint8_t SIM_PIN_COUNT = 64;
+
+static uint64_t nowUs = 0;
+static bool advancing = false;
+
+static int pinLevel[SIM_PIN_COUNT];
+static bool pinInit = false;
+static void (*pinIsr[SIM_PIN_COUNT])(void);
+static void (*pinIsrWithArg[SIM_PIN_COUNT])(void *);
+static void *pinIsrArg[SIM_PIN_COUNT];
+static int pinIsrMode[SIM_PIN_COUNT];
+static float batteryVolts = 3.9f;
+
+static std::deque<char> serialIn;
+
+static uint64_t sleepTimerUs = 0;
+static bool gpioWakeEnabled = false;
+static int wakeLevel[SIM_PIN_COUNT];
+static bool wakeLevelInit = false;
+static esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static uint64_t lightSleepUs = 0;
+static uint32_t lightSleeps = 0;
+
+uint64_t simScriptNextDueUs();
+void simScriptRunDue();
+
+
+// ======== Virtual clock ========
+
+uint64_t simNowUs() {
+  return nowUs;
+}
+
+void simAdvanceUs(uint64_t us) {
+  uint64_t target = nowUs + us;
+
+  // Events raised while handling an event (an ISR calling millis(), a UART
+  // callback) must not advance time again
+  if (advancing) return;
+  advancing = true;
+
+  while (true) {
+    uint64_t next = std::min(simScriptNextDueUs(), simDFPlayerNextDueUs());
+    if (next > target) break;
+    if (next > nowUs) nowUs = next;
+    simScriptRunDue();
+    simDFPlayerDeliver();
+  }
+  nowUs = target;
+  advancing = false;
+}
+
+// Reading the clock costs a little CPU time, so busy-wait loops terminate
+unsigned long millis() { simAdvanceUs(1); return (unsigned long)(nowUs / 1000); }
+unsigned long micros() { simAdvanceUs(1); return (unsigned long)nowUs; }
+void delay(unsigned long ms) { simAdvanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { simAdvanceUs(us); }
+void yield() { simAdvanceUs(10); }
+
+
+// ======== Random ========
+
+static uint32_t randomState = 0x2545F491;
+
+void randomSeed(unsigned long seed) {
+  if (seed) randomState = (uint32_t)seed;
+}
+
+// xorshift32
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (long)(randomState % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+
+// ======== Pins ========
+
+static void initPins() {
+  if (pinInit) return;
+  // Everything idles high (pull-ups); active-low buttons read as released
+  for (uint8_t i = 0; i < SIM_PIN_COUNT; i++) pinLevel[i] = HIGH;
+  pinInit = true;
+}
+
+void simSetPin(uint8_t pin, int level) {
+  initPins();
+  if (pin >= SIM_PIN_COUNT || pinLevel[pin] == level) return;
+  pinLevel[pin] = level;
+
+  if (!pinIsr[pin] && !pinIsrWithArg[pin]) return;
+  int mode = pinIsrMode[pin];
+  if (mode == CHANGE || (mode == FALLING && level == LOW) || (mode == RISING && level == HIGH)) {
+    if (pinIsr[pin]) pinIsr[pin]();
+    else pinIsrWithArg[pin](pinIsrArg[pin]);
+  }
+}
+
+int simGetPin(uint8_t pin) {
+  initPins();
+  return pin < SIM_PIN_COUNT ? pinLevel[pin] : LOW;
+}
+
+void simSetBatteryVolts(float volts) {
+  batteryVolts = volts;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+int digitalRead(uint8_t pin) {
+  return simGetPin(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  simSetPin(pin, val ? HIGH : LOW);
+}
+
+void analogWrite(uint8_t, int) {}
+
+// The status light has nothing to drive on the host
+bool ledcSetClockSource(ledc_clk_cfg_t) { return true; }
+bool ledcAttach(uint8_t, uint32_t, uint8_t) { return true; }
+bool ledcWrite(uint8_t, uint32_t) { return true; }
+bool ledcFade(uint8_t, uint32_t, uint32_t, int) { return true; }
+
+uint32_t analogReadMilliVolts(uint8_t) {
+  // A little ADC noise, and every 25th reading a deep dip as if the
+  // amplifier had just hit a peak
+  static uint32_t seed = 1;
+  static uint32_t readings = 0;
+  seed = seed * 1103515245u + 12345u;
+  float noise = ((int)((seed >> 16) % 31) - 15) / 1000.0f;
+  float glitch = ++readings % 25 == 0 ? 0.4f : 0.0f;
+
+  // The battery sits behind a 1:2 divider
+  float volts = batteryVolts - simAudioSagVolts() + noise - glitch;
+  return (uint32_t)(volts * 1000.0f / 2.0f);
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if (pin >= SIM_PIN_COUNT) return;
+  pinIsr[pin] = handler;
+  pinIsrWithArg[pin] = nullptr;
+  pinIsrMode[pin] = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {
+  if (pin >= SIM_PIN_COUNT) return;
+  pinIsr[pin] = nullptr;
+  pinIsrWithArg[pin] = handler;
+  pinIsrArg[pin] = arg;
+  pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin >= SIM_PIN_COUNT) return;
+  pinIsr[pin] = nullptr;
+  pinIsrWithArg[pin] = nullptr;
+}
+
+
+// ======== Sleep ========
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t, esp_sleep_ext1_wakeup_mode_t) { return ESP_OK; }
+esp_err_t esp_sleep_pd_config(esp_sleep_pd_domain_t, esp_sleep_pd_option_t) { return ESP_OK; }
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) {
+  sleepTimerUs = us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+  gpioWakeEnabled = true;
+  return ESP_OK;
+}
+
+static void initWakeLevels() {
+  if (wakeLevelInit) return;
+  for (uint8_t i = 0; i < SIM_PIN_COUNT; i++) wakeLevel[i] = -1;
+  wakeLevelInit = true;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+  initWakeLevels();
+  if (pin < 0 || pin >= SIM_PIN_COUNT) return -1;
+  wakeLevel[pin] = type == GPIO_INTR_LOW_LEVEL ? LOW : type == GPIO_INTR_HIGH_LEVEL ? HIGH : -1;
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t pin) {
+  initWakeLevels();
+  if (pin >= 0 && pin < SIM_PIN_COUNT) wakeLevel[pin] = -1;
+  return ESP_OK;
+}
+
+// Interrupts are dispatched by attachInterrupt()'s mode in the sim
+esp_err_t gpio_set_intr_type(gpio_num_t, gpio_int_type_t) {
+  return ESP_OK;
+}
+
+esp_err_t gpio_sleep_sel_dis(gpio_num_t) {
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+  return pin >= 0 ? simGetPin((uint8_t)pin) : LOW;
+}
+
+static bool gpioWakePending() {
+  if (!gpioWakeEnabled) return false;
+  initWakeLevels();
+  initPins();
+  for (uint8_t i = 0; i < SIM_PIN_COUNT; i++) {
+    if (wakeLevel[i] >= 0 && pinLevel[i] == wakeLevel[i]) return true;
+  }
+  return false;
+}
+
+// Fast-forward to the timer deadline or the first wake-level GPIO, whichever
+// comes first. Script events still happen on time (they are the outside world).
+esp_err_t esp_light_sleep_start() {
+  uint64_t start = nowUs;
+  uint64_t deadline = sleepTimerUs ? nowUs + sleepTimerUs : UINT64_MAX;
+  wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+  while (!simFinished()) {
+    if (gpioWakePending()) { wakeCause = ESP_SLEEP_WAKEUP_GPIO; break; }
+    if (nowUs >= deadline) { wakeCause = ESP_SLEEP_WAKEUP_TIMER; break; }
+    uint64_t next = std::min(deadline, std::min(simScriptNextDueUs(), simDFPlayerNextDueUs()));
+    if (next == UINT64_MAX) break;
+    simAdvanceUs(next > nowUs ? next - nowUs : 0);
+  }
+
+  lightSleepUs += nowUs - start;
+  lightSleeps++;
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return wakeCause;
+}
+
+uint64_t simLightSleepUs() {
+  return lightSleepUs;
+}
+
+uint32_t simLightSleeps() {
+  return lightSleeps;
+}
+
+void esp_deep_sleep_start() {
+  ::printf("[sim %8lu ms] 💤 deep sleep — simulation ends\n", millis());
+  simPrintSummary();
+  exit(0);
+}
+
+
+// ======== USB serial ========
+
+void simSerialInput(const char *line) {
+  for (const char *p = line; *p; p++) serialIn.push_back(*p);
+  serialIn.push_back('\n');
+}
+
+int SimSerial::available() {
+  return (int)serialIn.size();
+}
+
+int SimSerial::read() {
+  if (serialIn.empty()) return -1;
+  char c = serialIn.front();
+  serialIn.pop_front();
+  return (uint8_t)c;
+}
+
+int SimSerial::printf(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+size_t SimSerial::print(const char *s) { return (size_t)fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+size_t SimSerial::print(char c) { putchar(c); return 1; }
+size_t SimSerial::print(long n, int base) { return base == HEX ? printf("%lX", n) : printf("%ld", n); }
+size_t SimSerial::print(unsigned long n, int base) { return base == HEX ? printf("%lX", n) : printf("%lu", n); }
+size_t SimSerial::print(double n, int digits) { return printf("%.*f", digits, n); }
@@ -0,0 +1,155 @@
+// Host entry point: loads the event script, then runs setup() and loop()
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "config.h"
+#include "sim.h"
+
+void setup();
+void loop();
+size_t simParseHex(const char *hex, uint8_t *out, size_t cap);
+
+struct SimEvent {
+  uint64_t atUs;
+  std::string verb;
+  std::string arg;
+};
+
+static std::vector<SimEvent> events;
+static size_t nextEvent = 0;
+static bool finished = false;
+
+// Place a tag, take it off, place it again (served from the tag cache), then
+// nudge the volume with a short press on button 2
+static const char *DEMO_SCRIPT =
+  "3000  place 04A1B2C3D4E5F6 07 | volume 5 | shuffle\n"
+  "15000 remove\n"
+  "20000 place 04A1B2C3D4E5F6 07 | volume 5 | shuffle\n"
+  "25000 press 23\n"
+  "25200 release 23\n"
+  "30000 remove\n"
+  "40000 end\n";
+
+
+// ======== Script ========
+
+static void parseScript(const char *text) {
+  const char *line = text;
+  while (*line) {
+    const char *eol = strchr(line, '\n');
+    std::string l(line, eol ? (size_t)(eol - line) : strlen(line));
+    line = eol ? eol + 1 : line + l.size();
+
+    size_t hash = l.find('#');
+    if (hash != std::string::npos) l.erase(hash);
+
+    char verb[24];
+    unsigned long ms;
+    int consumed = 0;
+    if (sscanf(l.c_str(), "%lu %23s %n", &ms, verb, &consumed) < 2) continue;
+    std::string arg = consumed ? l.substr(consumed) : "";
+    while (!arg.empty() && isspace((unsigned char)arg.back())) arg.pop_back();
+    events.push_back({(uint64_t)ms * 1000, verb, arg});
+  }
+}
+
+bool simLoadScript(const char *path) {
+  if (!path) {
+    parseScript(DEMO_SCRIPT);
+    return true;
+  }
+
+  FILE *f = fopen(path, "r");
+  if (!f) return false;
+  std::string text;
+  char buf[256];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+  fclose(f);
+  parseScript(text.c_str());
+  return true;
+}
+
+bool simFinished() {
+  return finished;
+}
+
+void simRequestEnd() {
+  finished = true;
+}
+
+uint64_t simScriptNextDueUs() {
+  return nextEvent < events.size() ? events[nextEvent].atUs : UINT64_MAX;
+}
+
+static void runEvent(const SimEvent &e) {
+  ::printf("[sim %8lu ms] ▶ %s %s\n", millis(), e.verb.c_str(), e.arg.c_str());
+
+  if (e.verb == "place" || e.verb == "place-raw" || e.verb == "place-noread") {
+    size_t space = e.arg.find(' ');
+    std::string uid = e.arg.substr(0, space);
+    std::string rest = space == std::string::npos ? "" : e.arg.substr(space + 1);
+    SimTag tag;
+    if (e.verb == "place") {
+      if (!simBuildTextTag(uid.c_str(), rest.c_str(), tag)) return;
+    } else {
+      memset(&tag, 0, sizeof(tag));
+      tag.uidLen = (uint8_t)simParseHex(uid.c_str(), tag.uid, sizeof(tag.uid));
+      tag.memoryLen = simParseHex(rest.c_str(), tag.memory, sizeof(tag.memory));
+      tag.refusesRead = e.verb == "place-noread";
+    }
+    simPlaceTag(tag);
+  } else if (e.verb == "remove") {
+    simRemoveTag();
+  } else if (e.verb == "press") {
+    simSetPin((uint8_t)atoi(e.arg.c_str()), LOW);
+  } else if (e.verb == "release") {
+    simSetPin((uint8_t)atoi(e.arg.c_str()), HIGH);
+  } else if (e.verb == "battery") {
+    simSetBatteryVolts((float)atof(e.arg.c_str()));
+  } else if (e.verb == "nfc-fail" || e.verb == "nfc-ok") {
+    simSetNfcConnected(e.verb == "nfc-ok");
+  } else if (e.verb == "dfplayer-fail" || e.verb == "dfplayer-ok") {
+    simSetDFPlayerConnected(e.verb == "dfplayer-ok");
+  } else if (e.verb == "wifi-fail" || e.verb == "wifi-ok") {
+    simSetWifiAvailable(e.verb == "wifi-ok");
+  } else if (e.verb == "serial") {
+    simSerialInput(e.arg.c_str());
+  } else if (e.verb == "end") {
+    simRequestEnd();
+  } else {
+    ::printf("[sim] unknown event '%s'\n", e.verb.c_str());
+  }
+}
+
+void simScriptRunDue() {
+  while (nextEvent < events.size() && events[nextEvent].atUs <= simNowUs()) {
+    runEvent(events[nextEvent++]);
+  }
+}
+
+
+// ======== Main ========
+
+// Unit tests (test/, `pio test -e native`) bring their own main() and drive
+// the virtual clock themselves
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  const char *script = argc > 1 ? argv[1] : nullptr;
+  if (!simLoadScript(script)) {
+    ::fprintf(stderr, "cannot read script %s\n", script);
+    return 1;
+  }
+
+  simSetPin(Switch_pin, LOW);   // power switch on, so setup() doesn't go to sleep
+  simSetNfcIrqPin(NFC_IRQ_pin);
+  simSetDFPlayerBusyPin(DF_BUSY_pin);
+
+  setup();
+  while (!simFinished()) loop();
+
+  simPrintSummary();
+  return 0;
+}
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,182 @@
+// Simulated Wi-Fi + MQTT uplink behind the TelemetryLink interface.
+//
+// Joining the network and opening the broker session take virtual time, and
+// every published message is printed. With SIM_MQTT_BROKER=host[:port] in the
+// environment the messages also go to a real broker (e.g. a local mosquitto),
+// through a minimal MQTT 3.1.1 client: CONNECT, PUBLISH at QoS 0, DISCONNECT.
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include "Arduino.h"
+#include "hal.h"
+#include "sim.h"
+
+#define SIM_LOG(...) do { ::printf("[sim %8lu ms] ", millis()); ::printf(__VA_ARGS__); } while (0)
+
+static bool wifiAvailable = true;
+static uint32_t mqttMessages = 0;
+static uint32_t mqttBytes = 0;
+
+
+// ======== Real broker (optional) ========
+
+static size_t mqttRemainingLength(uint8_t *out, size_t len) {
+  size_t n = 0;
+  do {
+    uint8_t b = len % 128;
+    len /= 128;
+    if (len) b |= 0x80;
+    out[n++] = b;
+  } while (len);
+  return n;
+}
+
+static bool sendAll(int fd, const void *buf, size_t len) {
+  const uint8_t *p = static_cast<const uint8_t *>(buf);
+  while (len) {
+    ssize_t n = send(fd, p, len, 0);
+    if (n <= 0) return false;
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// Fixed header + body as one packet
+static bool sendPacket(int fd, uint8_t type, const std::string &body) {
+  uint8_t header[5] = {type};
+  size_t h = 1 + mqttRemainingLength(header + 1, body.size());
+  return sendAll(fd, header, h) && sendAll(fd, body.data(), body.size());
+}
+
+static std::string mqttString(const char *s, size_t len) {
+  std::string out;
+  out += (char)(len >> 8);
+  out += (char)(len & 0xFF);
+  out.append(s, len);
+  return out;
+}
+
+static int brokerOpen(const char *spec) {
+  std::string host = spec;
+  std::string port = "1883";
+  size_t colon = host.rfind(':');
+  if (colon != std::string::npos) {
+    port = host.substr(colon + 1);
+    host.erase(colon);
+  }
+
+  addrinfo hints = {};
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) return -1;
+
+  timeval timeout = {2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // CONNECT: protocol "MQTT" level 4, clean session, 60 s keepalive
+  const char *clientId = "musicbox-sim";
+  std::string body = mqttString("MQTT", 4);
+  body += (char)0x04;
+  body += (char)0x02;
+  body += (char)0x00;
+  body += (char)60;
+  body += mqttString(clientId, strlen(clientId));
+
+  uint8_t connack[4];
+  if (!sendPacket(fd, 0x10, body) || recv(fd, connack, sizeof(connack), MSG_WAITALL) != sizeof(connack) ||
+      connack[0] != 0x20 || connack[3] != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+
+// ======== Link ========
+
+class SimTelemetryLink : public TelemetryLink {
+public:
+  void connect() override {
+    startUs = simNowUs();
+    state = LINK_CONNECTING;
+    SIM_LOG("📶 Wi-Fi on\n");
+  }
+
+  LinkState poll() override {
+    if (state != LINK_CONNECTING) return state;
+
+    uint64_t waited = simNowUs() - startUs;
+    if (!wifiAvailable) {
+      if (waited >= SIM_WIFI_SCAN_US) state = LINK_FAILED; // the scan found no network
+      return state;
+    }
+    if (waited < SIM_WIFI_JOIN_US) return state;
+
+    simAdvanceUs(SIM_MQTT_CONNECT_US);
+    const char *broker = getenv("SIM_MQTT_BROKER");
+    if (broker) {
+      fd = brokerOpen(broker);
+      if (fd < 0) {
+        SIM_LOG("⚠️ MQTT broker %s not reachable\n", broker);
+        return state = LINK_FAILED;
+      }
+    }
+    return state = LINK_UP;
+  }
+
+  bool publish(const char *topic, const char *payload, size_t len) override {
+    if (state != LINK_UP) return false;
+    simAdvanceUs(SIM_MQTT_PUBLISH_US);
+
+    if (fd >= 0) {
+      std::string body = mqttString(topic, strlen(topic));
+      body.append(payload, len);
+      if (!sendPacket(fd, 0x30, body)) return false;
+    }
+
+    mqttMessages++;
+    mqttBytes += (uint32_t)(len + strlen(topic));
+    SIM_LOG("📡 MQTT %s (%zu bytes): %.*s\n", topic, len, (int)len, payload);
+    return true;
+  }
+
+  void disconnect() override {
+    if (fd >= 0) {
+      sendPacket(fd, 0xE0, "");
+      close(fd);
+      fd = -1;
+    }
+    if (state != LINK_OFF) SIM_LOG("📶 Wi-Fi off after %.1f s\n", (simNowUs() - startUs) / 1e6);
+    state = LINK_OFF;
+  }
+
+private:
+  LinkState state = LINK_OFF;
+  uint64_t startUs = 0;
+  int fd = -1;
+};
+
+static SimTelemetryLink simLink;
+TelemetryLink &telemetryLink = simLink;
+
+void simSetWifiAvailable(bool available) {
+  wifiAvailable = available;
+}
+
+uint32_t simMqttMessages() {
+  return mqttMessages;
+}
+
+uint32_t simMqttBytes() {
+  return mqttBytes;
+}
@@ -0,0 +1,486 @@
+// Simulated PN532 + NTAG tags, DFPlayer Mini and NVS, behind the HAL interfaces
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "df_frame.h"
+#include "hal.h"
+#include "sim.h"
+
+#define SIM_LOG(...) do { ::printf("[sim %8lu ms] ", millis()); ::printf(__VA_ARGS__); } while (0)
+
+
+// ======== PN532 + tags ========
+
+static SimTag currentTag;
+static bool tagOnReader = false;
+static bool nfcConnected = true;
+static bool detectionArmed = false;
+static bool tagSelected = false;   // the last detection selected the tag; READs need that
+static uint8_t activationRetries = 0xFF; // the PN532's default after a reset: forever
+static int irqPin = -1;
+static uint32_t pageZeroReads = 0;
+
+static bool nfcAsleep = false;
+static uint64_t nfcSleepStartUs = 0;
+static uint64_t nfcAsleepUs = 0;
+static uint32_t nfcWakeups = 0;
+
+class SimNfcReader : public NfcReader {
+public:
+  bool begin() override {
+    wake();
+    activationRetries = 0xFF;
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    return nfcConnected;
+  }
+  uint32_t getFirmwareVersion() override {
+    wake();
+    detectionArmed = false;
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    return nfcConnected ? 0x32010607 : 0;
+  }
+  bool SAMConfig() override { wake(); simAdvanceUs(SIM_NFC_COMMAND_US); return nfcConnected; }
+  bool setPassiveActivationRetries(uint8_t maxRetries) override {
+    wake();
+    detectionArmed = false;
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    if (nfcConnected) activationRetries = maxRetries;
+    return nfcConnected;
+  }
+
+  bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLen, uint16_t timeoutMs) override {
+    wake();
+    detectionArmed = false;
+    tagSelected = false;
+    if (!nfcConnected || !tagOnReader) {
+      // The real call waits out its timeout, unless the PN532 gives up first
+      uint64_t waitUs = (uint64_t)timeoutMs * 1000;
+      if (nfcConnected && activationRetries != 0xFF) {
+        waitUs = min(waitUs, (uint64_t)(activationRetries + 1) * SIM_NFC_ATTEMPT_US);
+      }
+      simAdvanceUs(waitUs);
+      return false;
+    }
+    simAdvanceUs(SIM_NFC_DETECT_US);
+    tagSelected = true;
+    return copyUid(uid, uidLen);
+  }
+
+  bool startPassiveTargetIDDetection() override {
+    wake();
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    if (!nfcConnected) return false;
+    detectionArmed = true;
+    tagSelected = false;
+    updateIrq();
+    return true;
+  }
+
+  bool readDetectedPassiveTargetID(uint8_t *uid, uint8_t *uidLen) override {
+    wake();
+    bool ok = detectionArmed && tagOnReader;
+    detectionArmed = false;
+    tagSelected = ok;
+    updateIrq();
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    return ok && copyUid(uid, uidLen);
+  }
+
+  bool readPage(uint8_t page, uint8_t *buf) override {
+    uint8_t block[16];
+    if (!readPages(page, block)) return false;
+    memcpy(buf, block, 4);
+    return true;
+  }
+
+  bool readPages(uint8_t page, uint8_t *buf) override {
+    wake();
+    detectionArmed = false;
+    simAdvanceUs(SIM_NFC_READ_US);
+    if (page == 0) pageZeroReads++;
+    // A tag that left the field (or was never selected) NAKs, and has to be
+    // detected again before it answers another READ
+    if (!nfcConnected || !tagOnReader || !tagSelected || currentTag.refusesRead) {
+      tagSelected = false;
+      return false;
+    }
+    for (uint8_t i = 0; i < 16; i++) buf[i] = tagByte(page * 4 + i);
+    return true;
+  }
+
+  bool powerDown() override {
+    if (nfcAsleep) return true;
+    simAdvanceUs(SIM_NFC_COMMAND_US);
+    if (!nfcConnected) return false;
+    detectionArmed = false;
+    tagSelected = false; // RF field off
+    nfcAsleep = true;
+    nfcSleepStartUs = simNowUs();
+    return true;
+  }
+  bool poweredDown() const override { return nfcAsleep; }
+
+  static void updateIrq() {
+    if (irqPin >= 0) simSetPin((uint8_t)irqPin, (detectionArmed && tagOnReader) ? LOW : HIGH);
+  }
+
+private:
+  // SS pulse, oscillator start-up, then SAMConfig
+  void wake() {
+    if (!nfcAsleep) return;
+    nfcAsleep = false;
+    nfcAsleepUs += simNowUs() - nfcSleepStartUs;
+    nfcWakeups++;
+    simAdvanceUs(SIM_NFC_WAKE_US + SIM_NFC_COMMAND_US);
+  }
+
+  // NTAG memory: UID, BCCs, lock bytes and CC in pages 0-3, then user memory
+  static uint8_t tagByte(size_t addr) {
+    if (addr >= 16) {
+      size_t user = addr - 16;
+      return user < currentTag.memoryLen ? currentTag.memory[user] : 0;
+    }
+    const uint8_t *u = currentTag.uid;
+    uint8_t header[16] = {u[0], u[1], u[2], (uint8_t)(0x88 ^ u[0] ^ u[1] ^ u[2]),
+                          u[3], u[4], u[5], u[6],
+                          (uint8_t)(u[3] ^ u[4] ^ u[5] ^ u[6]), 0x48, 0x00, 0x00,
+                          0xE1, 0x10, 0x6D, 0x00};
+    return header[addr];
+  }
+
+  bool copyUid(uint8_t *uid, uint8_t *uidLen) {
+    memcpy(uid, currentTag.uid, currentTag.uidLen);
+    *uidLen = currentTag.uidLen;
+    return true;
+  }
+};
+
+void simPlaceTag(const SimTag &tag) {
+  currentTag = tag;
+  tagOnReader = true;
+  tagSelected = false;
+  SimNfcReader::updateIrq();
+}
+
+void simRemoveTag() {
+  tagOnReader = false;
+  tagSelected = false;
+  SimNfcReader::updateIrq();
+}
+
+void simSetNfcConnected(bool connected) {
+  nfcConnected = connected;
+}
+
+void simSetNfcIrqPin(int pin) {
+  irqPin = pin;
+  SimNfcReader::updateIrq();
+}
+
+uint32_t simNfcPageZeroReads() {
+  return pageZeroReads;
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  c = (char)tolower((unsigned char)c);
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Parse hex digits (separators ignored) into out[]; returns the byte count
+size_t simParseHex(const char *hex, uint8_t *out, size_t cap) {
+  size_t n = 0;
+  int hi = -1;
+  for (const char *p = hex; *p && n < cap; p++) {
+    int v = hexNibble(*p);
+    if (v < 0) continue;
+    if (hi < 0) { hi = v; continue; }
+    out[n++] = (uint8_t)(hi << 4 | v);
+    hi = -1;
+  }
+  return n;
+}
+
+// An NDEF message TLV holding one Text record ("en"), then the terminator TLV
+bool simBuildTextTag(const char *uidHex, const char *text, SimTag &out) {
+  memset(&out, 0, sizeof(out));
+  out.uidLen = (uint8_t)simParseHex(uidHex, out.uid, sizeof(out.uid));
+  if (out.uidLen != 4 && out.uidLen != 7) return false;
+
+  size_t textLen = strlen(text);
+  size_t payloadLen = 3 + textLen;                  // status + "en" + text
+  bool shortRecord = payloadLen <= 255;
+  size_t recordLen = (shortRecord ? 4 : 7) + payloadLen;
+  if (recordLen + 5 > sizeof(out.memory)) return false;
+
+  uint8_t *m = out.memory;
+  size_t i = 0;
+  m[i++] = 0x03;                                    // NDEF message TLV
+  if (recordLen < 0xFF) {
+    m[i++] = (uint8_t)recordLen;
+  } else {
+    m[i++] = 0xFF;
+    m[i++] = (uint8_t)(recordLen >> 8);
+    m[i++] = (uint8_t)recordLen;
+  }
+  m[i++] = shortRecord ? 0xD1 : 0xC1;               // MB|ME|(SR)|TNF=well-known
+  m[i++] = 0x01;                                    // type length
+  if (shortRecord) {
+    m[i++] = (uint8_t)payloadLen;
+  } else {
+    for (int s = 24; s >= 0; s -= 8) m[i++] = (uint8_t)(payloadLen >> s);
+  }
+  m[i++] = 'T';
+  m[i++] = 0x02;                                    // UTF-8, 2-byte language code
+  m[i++] = 'e';
+  m[i++] = 'n';
+  memcpy(m + i, text, textLen);
+  i += textLen;
+  m[i++] = 0xFE;                                    // terminator TLV
+  out.memoryLen = i;
+  return true;
+}
+
+
+// ======== DFPlayer Mini ========
+
+struct SimReply {
+  uint64_t dueUs;
+  DFFrame frame;
+};
+
+class SimDFPlayer : public SerialPort {
+public:
+  void begin() override { rx.clear(); }
+  int available() override { return (int)rx.size(); }
+  int read() override {
+    if (rx.empty()) return -1;
+    uint8_t b = rx.front();
+    rx.pop_front();
+    return b;
+  }
+
+  size_t write(const uint8_t *buf, size_t len) override {
+    DFFrame f;
+    for (size_t i = 0; i < len; i++) {
+      if (decoder.push(buf[i], f)) handle(f);
+    }
+    return len;
+  }
+
+  void onReceive(SerialRxFn fn, void *ctx) override {
+    rxFn = fn;
+    rxCtx = ctx;
+  }
+
+  uint64_t nextDueUs() const {
+    uint64_t next = UINT64_MAX;
+    for (const SimReply &r : replies) next = std::min(next, r.dueUs);
+    if (trackEndUs) next = std::min(next, trackEndUs);
+    return next;
+  }
+
+  void deliver() {
+    uint64_t now = simNowUs();
+    if (trackEndUs && trackEndUs <= now) finishTrack();
+
+    bool any = false;
+    for (size_t i = 0; i < replies.size();) {
+      if (replies[i].dueUs > now) { i++; continue; }
+      uint8_t buf[DF_FRAME_LEN];
+      dfEncodeFrame(replies[i].frame, buf);
+      for (uint8_t b : buf) rx.push_back(b);
+      replies.erase(replies.begin() + i);
+      any = true;
+    }
+    if (any && rxFn) rxFn(rxCtx);
+  }
+
+  bool playing() const { return trackEndUs != 0; }
+
+  void setBusyPin(int pin) {
+    busyPin = pin;
+    updateBusy();
+  }
+
+  bool connected = true;
+  uint32_t commands = 0;
+  uint8_t volume = 15;
+
+private:
+  void reply(uint8_t cmd, uint16_t param, uint32_t delayUs = SIM_DF_REPLY_US) {
+    if (!connected) return;
+    replies.push_back({simNowUs() + delayUs, {cmd, false, param}});
+  }
+
+  void updateBusy() {
+    if (busyPin >= 0) simSetPin((uint8_t)busyPin, trackEndUs ? LOW : HIGH);
+  }
+
+  void play(uint8_t folder, uint8_t track, bool loop) {
+    playingFolder = folder;
+    playingTrack = track;
+    looping = loop;
+    trackEndUs = simNowUs() + (folder == 1 ? SIM_CHIME_US : SIM_TRACK_US);
+    updateBusy();
+    SIM_LOG("🎵 DFPlayer plays folder %02u track %03u%s at volume %u\n", folder, track, loop ? " (loop)" : "", volume);
+  }
+
+  void finishTrack() {
+    trackEndUs = 0;
+    updateBusy();
+    reply(DF_EVT_TRACK_FINISHED, playingTrack, 0);
+    reply(DF_EVT_TRACK_FINISHED, playingTrack, 0); // the module always sends it twice
+    if (looping) play(playingFolder, playingTrack + 1, true);
+  }
+
+  void handle(const DFFrame &f) {
+    if (!connected) return;
+    commands++;
+    bool ok = true;
+
+    switch (f.cmd) {
+      case DF_CMD_RESET:
+        trackEndUs = 0;
+        updateBusy();
+        reply(DF_EVT_ONLINE, 0x0002, SIM_DF_BOOT_US);
+        break;
+      case DF_CMD_VOLUME:
+        volume = (uint8_t)f.param;
+        break;
+      case DF_CMD_PLAY_FOLDER:
+        ok = (f.param & 0xFF) >= 1 && (f.param & 0xFF) <= SIM_FOLDER_TRACKS;
+        if (ok) play(f.param >> 8, f.param & 0xFF, false);
+        break;
+      case DF_CMD_LOOP_FOLDER:
+        play((uint8_t)f.param, 1, true);
+        break;
+      case DF_CMD_STOP:
+        if (trackEndUs) SIM_LOG("⏹️ DFPlayer stops\n");
+        trackEndUs = 0;
+        updateBusy();
+        break;
+      case DF_CMD_NEXT:
+        if (trackEndUs) play(playingFolder, playingTrack + 1, looping);
+        break;
+      case DF_CMD_PREVIOUS:
+        if (trackEndUs) play(playingFolder, playingTrack > 1 ? playingTrack - 1 : 1, looping);
+        break;
+      case DF_QUERY_VOLUME:
+        reply(DF_QUERY_VOLUME, volume);
+        break;
+      case DF_QUERY_FOLDER_FILES:
+        reply(DF_QUERY_FOLDER_FILES, SIM_FOLDER_TRACKS);
+        break;
+      case DF_QUERY_SD_FILES:
+        reply(DF_QUERY_SD_FILES, SIM_FOLDER_TRACKS * 10);
+        break;
+      default:
+        break;
+    }
+
+    if (!f.feedback) return;
+    if (ok) reply(DF_EVT_ACK, 0);
+    else reply(DF_EVT_ERROR, 0x06); // file not found
+  }
+
+  DFFrameDecoder decoder;
+  std::deque<uint8_t> rx;
+  std::vector<SimReply> replies;
+  SerialRxFn rxFn = nullptr;
+  void *rxCtx = nullptr;
+
+  uint8_t playingFolder = 0;
+  uint8_t playingTrack = 0;
+  bool looping = false;
+  uint64_t trackEndUs = 0;
+  int busyPin = -1;
+};
+
+
+// ======== NVS ========
+
+class SimStorage : public Storage {
+public:
+  bool begin(const char *ns, bool) override { prefix = std::string(ns) + "/"; return true; }
+  void end() override {}
+
+  uint32_t getUInt(const char *key, uint32_t defaultValue) override {
+    uint32_t v = defaultValue;
+    auto it = data.find(prefix + key);
+    if (it != data.end() && it->second.size() == sizeof(v)) memcpy(&v, it->second.data(), sizeof(v));
+    return v;
+  }
+  size_t putUInt(const char *key, uint32_t value) override { return putBytes(key, &value, sizeof(value)); }
+
+  size_t getBytesLength(const char *key) override {
+    auto it = data.find(prefix + key);
+    return it == data.end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char *key, void *buf, size_t len) override {
+    auto it = data.find(prefix + key);
+    if (it == data.end() || it->second.size() > len) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  size_t putBytes(const char *key, const void *buf, size_t len) override {
+    const uint8_t *p = static_cast<const uint8_t *>(buf);
+    data[prefix + key].assign(p, p + len);
+    writes++;
+    return len;
+  }
+
+  uint32_t writes = 0;
+
+private:
+  std::string prefix;
+  std::map<std::string, std::vector<uint8_t>> data;
+};
+
+
+// ======== HAL instances ========
+
+static SimNfcReader simNfc;
+static SimDFPlayer simDFPlayer;
+static SimStorage simStorage;
+
+NfcReader &nfc = simNfc;
+SerialPort &MP3Serial = simDFPlayer;
+Storage &storage = simStorage;
+
+void simSetDFPlayerConnected(bool connected) {
+  simDFPlayer.connected = connected;
+}
+
+void simSetDFPlayerBusyPin(int pin) {
+  simDFPlayer.setBusyPin(pin);
+}
+
+void simDFPlayerDeliver() {
+  simDFPlayer.deliver();
+}
+
+uint64_t simDFPlayerNextDueUs() {
+  return simDFPlayer.nextDueUs();
+}
+
+float simAudioSagVolts() {
+  return simDFPlayer.playing() ? SIM_AUDIO_SAG_V * simDFPlayer.volume / 30.0f : 0.0f;
+}
+
+void simPrintSummary() {
+  ::printf("[sim] ---- summary after %.1f s virtual ----\n", simNowUs() / 1e6);
+  ::printf("[sim] DFPlayer commands: %lu, NVS writes: %lu\n",
+           (unsigned long)simDFPlayer.commands, (unsigned long)simStorage.writes);
+  ::printf("[sim] MQTT messages: %lu, %lu bytes\n", (unsigned long)simMqttMessages(), (unsigned long)simMqttBytes());
+
+  ::printf("[sim] ESP32 in light sleep %.1f%% of the time (%lu sleeps)\n",
+           simNowUs() ? 100.0 * simLightSleepUs() / simNowUs() : 0.0, (unsigned long)simLightSleeps());
+
+  uint64_t asleep = nfcAsleepUs + (nfcAsleep ? simNowUs() - nfcSleepStartUs : 0);
+  ::printf("[sim] PN532 powered down %.1f%% of the time, %lu wakeups\n",
+           simNowUs() ? 100.0 * asleep / simNowUs() : 0.0, (unsigned long)nfcWakeups);
+}
@@ -0,0 +1,53 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <atomic>
+#include "app_state.h"
+#include "app_tasks.h"
+#include "log.h"
+
+SpscQueue<TagEvent, 8> tagEvents;
+SpscQueue<UiEvent, 8> uiEvents;
+
+static BoxState state = {};
+static std::atomic<uint32_t> stateSeq{0}; // odd while a write is in progress
+
+
+// ======== Queues ========
+
+bool sendTagEvent(const TagEvent &e) {
+  if (!tagEvents.push(e)) {
+    LOG_W("⚠️ Tag event queue full, event dropped");
+    return false;
+  }
+  appTaskNotify(APP_TASK_AUDIO);
+  return true;
+}
+
+bool sendUiEvent(UiEventType type, uint32_t startUs) {
+  if (!uiEvents.push({type, startUs})) return false; // button mashing: drop the extra presses
+  appTaskNotify(APP_TASK_AUDIO);
+  return true;
+}
+
+
+// ======== Snapshot ========
+
+void publishBoxState(const BoxState &s) {
+  uint32_t seq = stateSeq.load(std::memory_order_relaxed);
+  stateSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  state = s;
+  stateSeq.store(seq + 2, std::memory_order_release);
+}
+
+BoxState readBoxState() {
+  BoxState copy;
+  uint32_t before, after;
+  do {
+    before = stateSeq.load(std::memory_order_acquire);
+    copy = state;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = stateSeq.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  return copy;
+}
@@ -0,0 +1,170 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <limits.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "app_tasks.h"
+#include "config.h"
+#include "latency.h"
+#include "log.h"
+
+Scheduler audioScheduler;
+Scheduler uiScheduler;
+Scheduler nfcScheduler;
+
+struct AppTask {
+  const char *name;
+  Scheduler *sched;
+  void (*drain)();
+  UBaseType_t priority;
+  uint32_t stackBytes;
+  TaskHandle_t handle = nullptr; // nullptr: stepped from loop()
+  uint64_t busyUs = 0;           // time spent in rounds (includes preemption by higher priorities)
+  uint32_t worstUs = 0;
+  uint32_t rounds = 0;
+};
+
+// DFPlayer traffic first, then button response, the PN532's slow SPI last.
+// The UI stack has room for Wi-Fi/MQTT calls, the NFC one for the NDEF buffer.
+static AppTask tasks[APP_TASK_COUNT] = {
+  {"audio", &audioScheduler, audioTaskDrain, 4, 4096},
+  {"ui",    &uiScheduler,    uiTaskDrain,    3, 8192},
+  {"nfc",   &nfcScheduler,   nullptr,        2, 6144},
+};
+
+static TaskHandle_t loopHandle = nullptr;
+static IdleFn idleFn = nullptr;
+static bool anySpawned = false;
+static unsigned long statsStart = 0;
+
+
+// ======== Rounds ========
+
+// Drain, run what's due; returns the ms until this task's next deadline
+static unsigned long runRound(AppTask &t) {
+  uint32_t start = micros();
+  if (t.drain) t.drain();
+  t.sched->tick();
+  uint32_t took = micros() - start;
+
+  t.busyUs += took;
+  if (took > t.worstUs) t.worstUs = took;
+  t.rounds++;
+  latencyRecord(LAT_LOOP, took);
+  return t.sched->msUntilNext();
+}
+
+static void taskBody(void *arg) {
+  AppTask &t = *static_cast<AppTask *>(arg);
+  for (;;) {
+    unsigned long wait = runRound(t);
+    if (wait == 0) {
+      taskYIELD();
+      continue;
+    }
+    TickType_t ticks = wait == ULONG_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+    ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+  }
+}
+
+
+// ======== Setup ========
+
+void appTasksStart() {
+  loopHandle = xTaskGetCurrentTaskHandle();
+  statsStart = millis();
+
+  Serial.print("🧵 Tasks:");
+  for (AppTask &t : tasks) {
+    if (APP_TASKS_RTOS &&
+        xTaskCreatePinnedToCore(taskBody, t.name, t.stackBytes, &t, t.priority, &t.handle, ARDUINO_RUNNING_CORE) != pdPASS) {
+      t.handle = nullptr;
+    }
+    anySpawned |= t.handle != nullptr;
+    Serial.printf(" %s (%s)", t.name, t.handle ? "FreeRTOS" : "loop");
+  }
+  Serial.println();
+}
+
+void appTaskNotify(AppTaskId id) {
+  if (id < APP_TASK_COUNT && tasks[id].handle) xTaskNotifyGive(tasks[id].handle);
+}
+
+void IRAM_ATTR appTaskNotifyFromIsr(AppTaskId id) {
+  if (id >= APP_TASK_COUNT || !tasks[id].handle) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(tasks[id].handle, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void appTasksWakeAll() {
+  for (uint8_t i = 0; i < APP_TASK_COUNT; i++) appTaskNotify((AppTaskId)i);
+}
+
+void appTasksSetIdleHandler(IdleFn fn) {
+  idleFn = fn;
+}
+
+
+// ======== loop() ========
+
+unsigned long appTasksMsUntilNext(bool skipSleepable) {
+  unsigned long best = ULONG_MAX;
+  for (AppTask &t : tasks) best = min(best, t.sched->msUntilNext(skipSleepable));
+  return best;
+}
+
+void appTasksLoop() {
+  bool stepped = false;
+  for (AppTask &t : tasks) {
+    if (t.handle) continue;
+    runRound(t);
+    stepped = true;
+  }
+
+  // Nothing else to do until the next deadline: hand the CPU back to the OS.
+  // A spawned task that is due runs on its own; here that is just a short wait.
+  unsigned long wait = appTasksMsUntilNext();
+  if (wait == 0 && stepped) {
+    yield();
+    return;
+  }
+  if (wait == 0) wait = 1;
+
+  // Print deferred log lines now that nothing is due; the sleep starts after
+  if (logDrain(LOG_DRAIN_PER_IDLE)) return;
+
+  if (idleFn) idleFn(wait);
+  else delay(min(wait, SCHEDULER_MAX_IDLE_MS));
+}
+
+
+// ======== Reporting ========
+
+void appTasksPrintStats() {
+  unsigned long elapsedMs = millis() - statsStart;
+  Serial.printf("🧵 Tasks over %lu s%s\n", elapsedMs / 1000, anySpawned ? "" : " (all stepped from loop())");
+
+  for (AppTask &t : tasks) {
+    Serial.printf("   %-6s prio %u  cpu %.1f%%  worst round %.1f ms  %lu rounds",
+                  t.name, (unsigned)t.priority,
+                  elapsedMs ? t.busyUs / 10.0 / elapsedMs : 0.0,
+                  t.worstUs / 1000.0, (unsigned long)t.rounds);
+    if (t.handle) Serial.printf("  stack %u B free", (unsigned)uxTaskGetStackHighWaterMark(t.handle));
+    Serial.println();
+    t.sched->printStats();
+  }
+  if (loopHandle && anySpawned) {
+    Serial.printf("   loop   stack %u B free\n", (unsigned)uxTaskGetStackHighWaterMark(loopHandle));
+  }
+}
+
+void appTasksResetStats() {
+  statsStart = millis();
+  for (AppTask &t : tasks) {
+    t.busyUs = 0;
+    t.worstUs = 0;
+    t.rounds = 0;
+    t.sched->resetStats();
+  }
+}
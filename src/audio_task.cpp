@@ -0,0 +1,403 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "app_state.h"
+#include "app_tasks.h"
+#include "battery.h"
+#include "boot.h"
+#include "config.h"
+#include "dfplayer.h"
+#include "folder_play.h"
+#include "health.h"
+#include "helpers.h"
+#include "latency.h"
+#include "log.h"
+#include "peripherals.h"
+#include "playback.h"
+#include "resume.h"
+#include "tag_parser.h"
+#include "telemetry.h"
+
+// Audio task: the only one that talks to the player. It acts on the tag and
+// button events the other tasks queue (app_state.h) and publishes the result
+// as the box state. It is also the only telemetry producer.
+
+static TagCommand currentCmd = {0, 1, -1, false, false}; // what the current record asked for
+static uint8_t playingUID[7] = {0};
+static uint8_t playingUIDLength = 0;
+static bool playing = false;
+static bool tagError = false;
+static bool readerOK = true;          // from the NFC task's health reports
+static bool dfBooting = true;         // the boot reset hasn't been answered yet
+static bool readerBooting = true;     // no health report from the NFC task yet
+static unsigned long playStartMs = 0; // for the removal event's play time
+
+static void serviceDFPlayer();
+static void dfHealthTask();
+static void resumeTask();
+static void publishState();
+static void onPlaybackAcked(uint8_t cmd, bool ok, uint16_t value);
+static void onRemovalChimeAcked(uint8_t cmd, bool ok, uint16_t value);
+static void onVolumeAcked(uint8_t cmd, bool ok, uint16_t value);
+static void onDFPlayerReset(uint8_t cmd, bool ok, uint16_t value);
+static unsigned long dfLastHeardMs();
+static bool dfCanProbe();
+static void dfProbe();
+static uint32_t dfReconnectJob(uint8_t stage);
+static void dfRestore();
+
+
+void audioTaskBegin() {
+  readerOK = nfcOK;
+
+  // Battery is checked first thing (the task is due on the first round)
+  audioScheduler.addTask("battery", checkBatteryAndSleepIfLow, Batt_Check_Interval);
+  audioScheduler.addTask("batt adc", batterySample, BATT_SAMPLE_INTERVAL);
+  int dfplayerTask = audioScheduler.addTask("dfplayer", serviceDFPlayer, DFPLAYER_SERVICE_INTERVAL);
+  audioScheduler.setSleepable(dfplayerTask, true); // vetoed while a command is out (main.cpp)
+  int dfHealthTaskId = audioScheduler.addTask("df health", dfHealthTask, CHECK_INTERVAL);
+  dfplayerHealth.begin("DFPlayer", audioScheduler, dfHealthTaskId,
+                       {dfLastHeardMs, dfCanProbe, dfProbe, dfReconnectJob, dfRestore}, DFPLAYER_SILENCE_TIMEOUT);
+  int resumeSaveTask = audioScheduler.addTask("resume", resumeTask, RESUME_SAVE_INTERVAL);
+  audioScheduler.setSleepable(resumeSaveTask, true); // removal saves anyway
+
+  // DFPlayer bring-up: the reset goes out on the first round and runs while
+  // the NFC task brings up the PN532; no drain, the frame decoder skips
+  // whatever the module printed while powering up
+  MP3Serial.begin();
+  player.onEvent(audioPlayerEvent);
+  if (bootResumed()) {
+    player.resume(MP3Serial);
+    dfBooting = false;
+    dfplayerHealth.booted(true);
+    dfplayerOK = true;
+    bootMark("DFPlayer resumed");
+  } else {
+    player.begin(MP3Serial, onDFPlayerReset);
+    bootMark("DFPlayer reset queued");
+  }
+
+  playbackBegin();
+  resumeTable.begin();
+  folderPlayBegin();
+  publishState();
+}
+
+
+// ======== DFPlayer ========
+
+// Push queued DFPlayer commands out and dispatch whatever came back
+static void serviceDFPlayer() {
+  player.service();
+  playbackService();
+}
+
+// Both peripherals have answered: greet the user, unless a record beat the
+// chime to it
+static void bootFinished() {
+  if (dfplayerOK && readerOK && !playing && playbackState() == PLAYBACK_STOPPED) {
+    playChime(1);
+    bootMark("startup chime");
+  }
+  bootPrintTimeline();
+}
+
+// The boot reset: the module reported in, or RESET_TIMEOUT_MS passed
+static void onDFPlayerReset(uint8_t cmd, bool ok, uint16_t value) {
+  dfBooting = false;
+  dfplayerHealth.booted(ok);
+  dfplayerOK = dfplayerHealth.ok();
+  if (ok) {
+    LOG_I("DFRobot player connected!");
+    bootMark("DFPlayer online");
+  } else {
+    LOG_E("❌ Connecting to DFPlayer Mini failed! Check wiring, SD card, and voltage levels.");
+    bootMark("DFPlayer timed out");
+  }
+  if (!readerBooting) bootFinished();
+  publishState();
+}
+
+
+// ---- Supervision (health.h) ----
+// Every frame and BUSY edge is a sign of life (playback.h)
+static unsigned long dfLastHeardMs() {
+  return playbackLastHeardMs();
+}
+
+// Not while a command is out: the ping would queue behind it
+static bool dfCanProbe() {
+  return player.idle() && playbackState() != PLAYBACK_STARTING;
+}
+
+// The volume query as a ping: any answer refreshes player.lastRxMillis()
+static void dfProbe() {
+  player.queryVolume(nullptr);
+}
+
+static void onDFPlayerReconnected(uint8_t cmd, bool ok, uint16_t value) {
+  dfplayerHealth.attemptDone(ok);
+  dfplayerOK = dfplayerHealth.ok();
+  publishState();
+}
+
+// Split into stages so the UART settle time doesn't stall the task
+static uint32_t dfReconnectJob(uint8_t stage) {
+  switch (stage) {
+    case 0:
+      MP3Serial.begin();
+      return 200;
+    default:
+      playbackReset();
+      player.begin(MP3Serial, onDFPlayerReconnected); // the reset's outcome is the attempt's
+      return JOB_DONE;
+  }
+}
+
+// The module came back from its reset with default settings: put the user's
+// volume back, and the record on the box where it was
+static void dfRestore() {
+  player.volume(volume);
+  if (!playing) return;
+  uint8_t track = folderPlayTrack() ? folderPlayTrack() : currentCmd.track;
+  LOG_I("⏯️ Restoring folder %u at track %u", currentCmd.folder, track);
+  folderPlayStart(currentCmd.folder, track, currentCmd.shuffle, nullptr);
+}
+
+// Reschedules itself (health.h)
+static void dfHealthTask() {
+  dfplayerHealth.check();
+  dfplayerOK = dfplayerHealth.ok();
+  publishState();
+}
+
+// Unsolicited frames from the DFPlayer
+void audioPlayerEvent(uint8_t event, uint16_t param) {
+  playbackFrame(event, param); // track finished: on to the next one from there
+  switch (event) {
+    case DF_EVT_CARD_REMOVED:
+      LOG_W("⚠️ DFPlayer: SD card removed");
+      break;
+    case DF_EVT_CARD_INSERTED:
+      LOG_I("DFPlayer: SD card inserted");
+      folderPlayCardChanged();
+      break;
+    case DF_EVT_ERROR:
+      LOG_W("⚠️ DFPlayer error %u", param);
+      break;
+    default:
+      break;
+  }
+}
+
+// The play command was ACKed: audio is starting, close the placement path
+static void onPlaybackAcked(uint8_t cmd, bool ok, uint16_t value) {
+  latencyRecord(LAT_DF_QUEUE, player.lastQueueWaitUs());
+  latencyRecord(LAT_DF_ACK, player.lastRoundTripUs());
+  if (ok) latencyEnd(LAT_PLACEMENT);
+  else latencyCancel(LAT_PLACEMENT);
+}
+
+// The removal chime replaced the record: playback has stopped
+static void onRemovalChimeAcked(uint8_t cmd, bool ok, uint16_t value) {
+  if (ok) latencyEnd(LAT_REMOVAL);
+  else latencyCancel(LAT_REMOVAL);
+}
+
+// The module ACKed the new volume: close the button latency path
+static void onVolumeAcked(uint8_t cmd, bool ok, uint16_t value) {
+  if (ok) latencyEnd(LAT_BUTTON);
+  else latencyCancel(LAT_BUTTON);
+}
+
+
+// ======== Playback ========
+
+// Restore the volume setting (from tag or default) without the tag's boost
+static void undoVolumeBoost() {
+  volume = volume - volume_boost;
+  volume_boost = 0;
+}
+
+// `firstTrack` is where to start an in-order record (its resume point)
+static void startPlayback(const TagCommand &cmd, uint8_t firstTrack) {
+  currentCmd = cmd;
+
+  // Set volume if specified
+  if (cmd.volume >= 0) {
+    // Only the part of the boost under MAX_VOLUME is applied, and undone
+    int boosted = min(volume + cmd.volume, MAX_VOLUME);
+    volume_boost = boosted - volume;
+    LOG_I("Changing volume by %d to a total of %d", cmd.volume, boosted);
+    player.volume(boosted);
+    volume = boosted;
+  }
+
+  // Play the folder, shuffled within itself if specified (folder_play.h)
+  if (cmd.shuffle) LOG_I("Shuffling folder %u.", cmd.folder);
+  else if (firstTrack > 1) LOG_I("⏯️ Resuming folder %u at track %u.", cmd.folder, firstTrack);
+  else LOG_I("Playing folder %u.", cmd.folder);
+  folderPlayStart(cmd.folder, firstTrack, cmd.shuffle, onPlaybackAcked);
+  playing = true;
+
+  playStartMs = millis();
+  telemetryTagEvent(TEL_PLAY, playingUID, playingUIDLength, cmd.folder, volume);
+}
+
+// Note where an in-order record is at (resume.h); shuffled ones start afresh
+static void rememberPosition() {
+  if (!playing || currentCmd.shuffle || !folderPlayActive()) return;
+  resumeTable.remember(playingUID, playingUIDLength, currentCmd.folder, folderPlayTrack());
+}
+
+// Back on the box: carry on where this record was taken off
+static uint8_t firstTrack(const TagEvent &e) {
+  uint8_t resumeAt = e.cmd.shuffle ? 0 : resumeTable.lookup(e.uid, e.uidLen, e.cmd.folder);
+  return resumeAt ? resumeAt : e.cmd.track;
+}
+
+// Scheduled every RESUME_SAVE_INTERVAL: a box switched off mid-record still
+// comes back close to where it was
+static void resumeTask() {
+  rememberPosition();
+  resumeTable.save();
+}
+
+static void handleTagEvent(const TagEvent &e) {
+  switch (e.type) {
+    case TAG_PLACED:
+      latencyBegin(LAT_PLACEMENT, e.startUs);
+
+      // A new record beats any chime still playing, and a swapped-in tag
+      // doesn't inherit the previous one's boost
+      cancelChime();
+      undoVolumeBoost();
+      player.volume(volume);
+
+      memcpy(playingUID, e.uid, sizeof(playingUID));
+      playingUIDLength = e.uidLen;
+      tagError = false;
+      startPlayback(e.cmd, firstTrack(e));
+      break;
+
+    case TAG_REWRITTEN:
+      // Undo the old tag's volume boost before applying the new command
+      undoVolumeBoost();
+      player.volume(volume);
+      startPlayback(e.cmd, firstTrack(e));
+      break;
+
+    case TAG_UNREADABLE:
+      tagError = true;
+      break;
+
+    case TAG_REMOVED:
+      latencyBegin(LAT_REMOVAL, e.startUs);
+      if (playing) {
+        telemetryTagEvent(TEL_REMOVE, playingUID, playingUIDLength,
+                          (int16_t)min((millis() - playStartMs) / 1000, 32767UL));
+      }
+      // Keep the record's place; this is the one flash write per listen
+      rememberPosition();
+      resumeTable.save();
+      playing = false;
+      folderPlayStop();
+      tagError = false;
+      playingUIDLength = 0;
+      memset(playingUID, 0, sizeof(playingUID));
+
+      // The chime replaces the record on the module; the chime job applies
+      // the restored volume as soon as the record scratch has played
+      undoVolumeBoost();
+
+      // Play removed chime at fixed volume (always 10)
+      playChime(2, onRemovalChimeAcked);
+      break;
+
+    case TAG_READER_HEALTH:
+      readerOK = e.ok;
+      if (readerBooting) {
+        readerBooting = false;
+        if (!dfBooting) bootFinished();
+      }
+      break;
+  }
+}
+
+static void handleUiEvent(const UiEvent &e) {
+  switch (e.type) {
+    case UI_VOLUME_UP:
+      latencyBegin(LAT_BUTTON, e.startUs);
+      volume = min(MAX_VOLUME, volume + 1);
+      player.volume(volume, onVolumeAcked);
+      LOG_I("Volume up: %d", volume);
+      telemetryEvent(TEL_VOLUME, volume);
+      break;
+
+    case UI_VOLUME_DOWN:
+      latencyBegin(LAT_BUTTON, e.startUs);
+      volume = max(MIN_VOLUME, volume - 2);
+      player.volume(volume, onVolumeAcked);
+      LOG_I("Volume down: %d", volume);
+      telemetryEvent(TEL_VOLUME, volume);
+      break;
+
+    case UI_NEXT_TRACK:
+      if (folderPlayActive()) folderPlayNext();
+      else player.next();
+      LOG_I("Skipping to next track");
+      break;
+
+    case UI_PREVIOUS_TRACK:
+      if (folderPlayActive()) folderPlayPrevious();
+      else player.previous();
+      LOG_I("Going back to previous track");
+      break;
+  }
+}
+
+void audioTaskDrain() {
+  bool changed = false;
+
+  playbackService(); // BUSY edges notify the task too
+
+  TagEvent tag;
+  while (tagEvents.pop(tag)) {
+    handleTagEvent(tag);
+    changed = true;
+  }
+
+  UiEvent ui;
+  while (uiEvents.pop(ui)) {
+    handleUiEvent(ui);
+    changed = true;
+  }
+
+  if (changed) publishState();
+}
+
+
+// ======== Box state ========
+
+static void publishState() {
+  static bool reportedDF = true;
+  static bool reportedNFC = true;
+
+  BoxState s = {};
+  s.playing = playing;
+  s.tagError = tagError;
+  memcpy(s.uid, playingUID, sizeof(s.uid));
+  s.uidLen = playingUIDLength;
+  s.folder = currentCmd.folder;
+  s.volume = volume;
+  s.dfplayerOK = dfplayerOK;
+  s.nfcOK = readerOK;
+  s.booting = dfBooting || readerBooting;
+  BatteryState batt = batteryState();
+  s.batteryLow = batt == BATT_LOW || (batt == BATT_OK && batteryPercent() <= BATT_WARN_PERCENT);
+  publishBoxState(s);
+
+  if (s.booting) return; // nothing to report until both have answered
+  if (dfplayerOK != reportedDF || readerOK != reportedNFC) telemetryEvent(TEL_HEALTH, dfplayerOK, readerOK);
+  reportedDF = dfplayerOK;
+  reportedNFC = readerOK;
+}
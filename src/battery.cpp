@@ -0,0 +1,117 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "battery.h"
+#include "config.h"
+
+static const uint8_t RING_SIZE = 7;      // median window: RING_SIZE * BATT_SAMPLE_INTERVAL
+static const float EMA_ALPHA = 0.25f;    // weight of each new median
+
+static uint16_t ring[RING_SIZE];  // load-compensated mV
+static uint8_t ringCount = 0;
+static uint8_t ringNext = 0;
+static float filtered = 0;
+static BatteryState state = BATT_NONE;
+static BatteryLoadFn loadFn = nullptr;
+static uint16_t lastRawMv = 0;
+
+// Resting LiPo voltage vs. state of charge (single cell, ~0.2C discharge)
+struct SocPoint {
+  uint16_t mv;
+  uint8_t pct;
+};
+
+static const SocPoint LIPO_CURVE[] = {
+  {4200, 100}, {4100, 90}, {4000, 80}, {3920, 70}, {3870, 60}, {3830, 50},
+  {3790, 40}, {3750, 30}, {3710, 20}, {3650, 10}, {3500, 5}, {3300, 0},
+};
+static const uint8_t CURVE_POINTS = sizeof(LIPO_CURVE) / sizeof(LIPO_CURVE[0]);
+
+
+// ======== Sampling ========
+
+// One conversion, corrected for the amplifier's draw at the current volume
+static uint16_t readCompensatedMv() {
+  lastRawMv = (uint16_t)(analogReadMilliVolts(VoltageReader_Pin) * BATT_DIVIDER_RATIO);
+  float mv = lastRawMv;
+  if (loadFn && loadFn()) mv += BATT_AUDIO_SAG_V * 1000.0f * volume / MAX_VOLUME;
+  return (uint16_t)mv;
+}
+
+static void push(uint16_t mv) {
+  ring[ringNext] = mv;
+  ringNext = (ringNext + 1) % RING_SIZE;
+  if (ringCount < RING_SIZE) ringCount++;
+}
+
+static uint16_t median() {
+  uint16_t sorted[RING_SIZE];
+  memcpy(sorted, ring, ringCount * sizeof(ring[0]));
+  // Insertion sort: at most 7 entries
+  for (uint8_t i = 1; i < ringCount; i++) {
+    uint16_t v = sorted[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = v;
+  }
+  return sorted[ringCount / 2];
+}
+
+// Hysteresis: once LOW, only WAKE_BAT_THRESHOLD brings it back
+static void updateState() {
+  float v = batteryVolts();
+  if (v < NO_BAT_THRESHOLD) state = BATT_NONE;
+  else if (state == BATT_LOW) { if (v >= WAKE_BAT_THRESHOLD) state = BATT_OK; }
+  else state = v < LOW_BAT_THRESHOLD ? BATT_LOW : BATT_OK;
+}
+
+
+// ======== Public ========
+
+void batteryBegin(bool startLow, BatteryLoadFn underLoad) {
+  loadFn = underLoad;
+  ringCount = ringNext = 0;
+  for (uint8_t i = 0; i < RING_SIZE; i++) push(readCompensatedMv());
+  filtered = median();
+  state = startLow ? BATT_LOW : BATT_OK;
+  updateState();
+}
+
+void batterySample() {
+  push(readCompensatedMv());
+  filtered += EMA_ALPHA * (median() - filtered);
+  updateState();
+}
+
+float batteryVolts() {
+  return filtered / 1000.0f;
+}
+
+uint8_t batteryPercent() {
+  float mv = filtered;
+  if (mv >= LIPO_CURVE[0].mv) return 100;
+  for (uint8_t i = 1; i < CURVE_POINTS; i++) {
+    const SocPoint &hi = LIPO_CURVE[i - 1];
+    const SocPoint &lo = LIPO_CURVE[i];
+    if (mv >= lo.mv) return (uint8_t)(lo.pct + (mv - lo.mv) * (hi.pct - lo.pct) / (hi.mv - lo.mv));
+  }
+  return 0;
+}
+
+BatteryState batteryState() {
+  return state;
+}
+
+const char *batteryStateName(BatteryState s) {
+  switch (s) {
+    case BATT_NONE: return "no battery";
+    case BATT_OK: return "OK";
+    case BATT_LOW: return "LOW";
+  }
+  return "?";
+}
+
+void batteryPrint() {
+  Serial.printf("🔋 Battery %.2f V (%u%%, %s); last reading %.2f V%s\n",
+                batteryVolts(), batteryPercent(), batteryStateName(state),
+                lastRawMv / 1000.0f, loadFn && loadFn() ? " under load" : "");
+}
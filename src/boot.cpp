@@ -0,0 +1,67 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <atomic>
+#include "boot.h"
+#include "log.h"
+
+struct BootPhase {
+  const char *name;
+  uint32_t atMs;
+};
+
+static const uint8_t MAX_PHASES = 16;
+static BootPhase phases[MAX_PHASES];
+static std::atomic<uint8_t> phaseCount(0); // the two peripherals' phases come from different tasks
+static bool tagReadReported = false;
+
+// Survives deep sleep, not a power cut. The magic tells a wake from a cold
+// boot, whose RTC memory holds whatever the power-up left there.
+static const uint32_t RTC_MAGIC = 0x4D424F58; // "MBOX"
+struct RtcPeripherals {
+  uint32_t magic;
+  bool dfplayerOK;
+  bool readerOK;
+};
+static RTC_DATA_ATTR RtcPeripherals rtcPeripherals;
+static bool resumed = false;
+
+
+// ======== Timeline ========
+
+void bootMark(const char *phase) {
+  uint8_t i = phaseCount.fetch_add(1, std::memory_order_relaxed);
+  if (i >= MAX_PHASES) return;
+  phases[i] = {phase, (uint32_t)millis()};
+}
+
+void bootPrintTimeline() {
+  uint8_t n = phaseCount.load(std::memory_order_relaxed);
+  if (n > MAX_PHASES) n = MAX_PHASES;
+  LOG_I("⏱️ Boot timeline (%s):", resumed ? "resumed from low-battery sleep" : "cold");
+  for (uint8_t i = 0; i < n; i++) LOG_I("⏱️ %5lu ms  %s", (unsigned long)phases[i].atMs, phases[i].name);
+}
+
+void bootTagRead() {
+  if (tagReadReported) return;
+  tagReadReported = true;
+  bootMark("first tag read");
+  LOG_I("⏱️ First tag read %lu ms after boot", (unsigned long)millis());
+}
+
+
+// ======== RTC memory ========
+
+void bootRememberPeripherals(bool dfplayer, bool reader) {
+  rtcPeripherals = {RTC_MAGIC, dfplayer, reader};
+}
+
+void bootBegin(bool lowBatteryWake) {
+  resumed = lowBatteryWake && rtcPeripherals.magic == RTC_MAGIC &&
+            rtcPeripherals.dfplayerOK && rtcPeripherals.readerOK;
+  rtcPeripherals.magic = 0; // one wake's worth: the next sleep writes it again
+  bootMark(resumed ? "peripherals known good (RTC)" : "peripherals need probing");
+}
+
+bool bootResumed() {
+  return resumed;
+}
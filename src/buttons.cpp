@@ -0,0 +1,190 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "app_state.h"
+#include "app_tasks.h"
+#include "buttons.h"
+#include "config.h"
+#include "spsc_queue.h"
+
+// ---- Button map ----
+// A short press sends `onPress`; holding for LONG_PRESS_TIME sends `onHold`,
+// then again every REPEAT_INTERVAL if `repeats`
+struct ButtonBinding {
+  int pin;
+  UiEventType onPress;
+  UiEventType onHold;
+  bool repeats;
+};
+
+static const ButtonBinding VOLUME_MAP[] = {
+  {Button2_pin, UI_VOLUME_UP,   UI_VOLUME_UP,   true},
+  {Button1_pin, UI_VOLUME_DOWN, UI_VOLUME_DOWN, true},
+};
+
+static const ButtonBinding SKIP_MAP[] = {
+  {Button2_pin, UI_NEXT_TRACK,     UI_NEXT_TRACK,     false},
+  {Button1_pin, UI_PREVIOUS_TRACK, UI_PREVIOUS_TRACK, false},
+};
+
+static_assert(sizeof(VOLUME_MAP) == sizeof(SKIP_MAP), "button maps must cover the same buttons");
+static const ButtonBinding *const BUTTONS = BUTTONS_SKIP_TRACKS ? SKIP_MAP : VOLUME_MAP;
+static const uint8_t BUTTON_COUNT = sizeof(VOLUME_MAP) / sizeof(VOLUME_MAP[0]);
+
+struct ButtonEdge {
+  uint8_t button;
+  bool pressed;
+  uint32_t atUs;
+};
+
+// Producer: the edge interrupt, or buttonsResync() with interrupts held off
+static SpscQueue<ButtonEdge, 32> edges;
+static volatile bool queuedPressed[BUTTON_COUNT]; // the level each button's last queued edge left it at
+static portMUX_TYPE producerLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Consumer: the UI task
+static ButtonState states[BUTTON_COUNT];
+static uint32_t presses = 0;
+static uint32_t longPresses = 0;
+static uint32_t repeats = 0;
+static uint32_t worstLagUs = 0; // edge to replay
+
+
+// ======== State machine ========
+
+ButtonAction buttonEdge(ButtonState &s, bool pressed, uint32_t atUs) {
+  // --- Button just pressed ---
+  if (pressed) {
+    if (!s.pressed) {
+      s.pressed = true;
+      s.pressStartUs = atUs;
+      s.longPressFired = false;
+    }
+    return BUTTON_NONE;
+  }
+
+  // --- Button just released: a press shorter than DEBOUNCE_TIME is a glitch ---
+  if (!s.pressed) return BUTTON_NONE;
+  s.pressed = false;
+  if (!s.longPressFired && atUs - s.pressStartUs > DEBOUNCE_TIME * 1000UL) return BUTTON_SHORT;
+  return BUTTON_NONE;
+}
+
+ButtonAction buttonHeld(ButtonState &s, uint32_t nowUs, bool repeats, uint32_t &dueUs) {
+  if (!s.pressed) return BUTTON_NONE;
+
+  // --- Button is being held ---
+  if (!s.longPressFired) {
+    dueUs = s.pressStartUs + LONG_PRESS_TIME * 1000UL;
+    if ((int32_t)(nowUs - dueUs) < 0) return BUTTON_NONE;
+    s.longPressFired = true;
+    s.nextRepeatUs = dueUs + REPEAT_INTERVAL * 1000UL;
+    return BUTTON_LONG;
+  }
+
+  if (!repeats || (int32_t)(nowUs - s.nextRepeatUs) < 0) return BUTTON_NONE;
+  dueUs = s.nextRepeatUs;
+  s.nextRepeatUs += REPEAT_INTERVAL * 1000UL;
+  return BUTTON_REPEAT;
+}
+
+
+// ======== Edge capture ========
+
+static void IRAM_ATTR queueEdge(uint8_t i, bool pressed, uint32_t atUs) {
+  if (pressed == queuedPressed[i]) return; // a level wake's repeated interrupts, or nothing changed
+  if (edges.push({i, pressed, atUs})) queuedPressed[i] = pressed;
+}
+
+static void IRAM_ATTR onButtonEdge(void *arg) {
+  uint8_t i = (uint8_t)(uintptr_t)arg;
+  portENTER_CRITICAL_ISR(&producerLock);
+  queueEdge(i, gpio_get_level((gpio_num_t)BUTTONS[i].pin) == 0, micros());
+  portEXIT_CRITICAL_ISR(&producerLock);
+  appTaskNotifyFromIsr(APP_TASK_UI);
+}
+
+void buttonsBegin() {
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    pinMode(BUTTONS[i].pin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(BUTTONS[i].pin), onButtonEdge, (void *)(uintptr_t)i, CHANGE);
+  }
+  buttonsResync(); // a button held through boot
+}
+
+// Light sleep stops the edge interrupts: compare the pins with what the
+// queue last said and queue the difference, timestamped now
+void buttonsResync() {
+  portENTER_CRITICAL(&producerLock);
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    queueEdge(i, gpio_get_level((gpio_num_t)BUTTONS[i].pin) == 0, now);
+  }
+  portEXIT_CRITICAL(&producerLock);
+  appTaskNotify(APP_TASK_UI);
+}
+
+
+// ======== Replay ========
+
+static void fire(uint8_t i, ButtonAction action, uint32_t atUs) {
+  const ButtonBinding &b = BUTTONS[i];
+  switch (action) {
+    case BUTTON_SHORT:
+      presses++;
+      sendUiEvent(b.onPress, atUs);
+      break;
+    case BUTTON_LONG:
+      longPresses++;
+      sendUiEvent(b.onHold, atUs);
+      break;
+    case BUTTON_REPEAT:
+      repeats++;
+      sendUiEvent(b.onHold, atUs);
+      break;
+    default:
+      break;
+  }
+}
+
+// Long presses and repeats due by `nowUs`, oldest first
+static void fireHeld(uint8_t i, uint32_t nowUs) {
+  uint32_t dueUs;
+  ButtonAction action;
+  while ((action = buttonHeld(states[i], nowUs, BUTTONS[i].repeats, dueUs)) != BUTTON_NONE) {
+    fire(i, action, dueUs);
+  }
+}
+
+void buttonsService() {
+  ButtonEdge e;
+  while (edges.pop(e)) {
+    int32_t lag = (int32_t)(micros() - e.atUs);
+    if (lag > (int32_t)worstLagUs) worstLagUs = lag;
+
+    // Whatever fell due while the button was held comes before the edge
+    fireHeld(e.button, e.atUs);
+    fire(e.button, buttonEdge(states[e.button], e.pressed, e.atUs), e.atUs);
+  }
+
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) fireHeld(i, now);
+}
+
+bool buttonsHeld() {
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    if (states[i].pressed) return true;
+  }
+  return false;
+}
+
+
+// ======== Reporting ========
+
+void buttonsPrintStats() {
+  Serial.printf("🔘 Buttons: %lu presses, %lu long, %lu repeats, worst replay lag %.1f ms, %lu edges dropped\n",
+                (unsigned long)presses, (unsigned long)longPresses, (unsigned long)repeats,
+                worstLagUs / 1000.0, (unsigned long)edges.droppedCount());
+  worstLagUs = 0;
+}
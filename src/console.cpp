@@ -0,0 +1,96 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "app_tasks.h"
+#include "battery.h"
+#include "console.h"
+#include "folder_play.h"
+#include "health.h"
+#include "latency.h"
+#include "log.h"
+#include "playback.h"
+#include "power.h"
+#include "resume.h"
+#include "tag_cache.h"
+#include "telemetry.h"
+
+static char line[48];
+static uint8_t lineLen = 0;
+
+struct ConsoleCommand {
+  const char *name;
+  void (*run)(const char *args);
+  const char *help;
+};
+
+static void cmdLatency(const char *args) {
+  if (strcmp(args, "reset") == 0) latencyReset();
+  else latencyPrint();
+}
+
+static void cmdStats(const char *args) {
+  appTasksPrintStats();
+  tagCache.printStats();
+  folderPlayPrintStats();
+  playbackPrintStats();
+  dfplayerHealth.printStats();
+  readerHealth.printStats();
+  resumeTable.printStats();
+  logPrintStats();
+}
+
+static void cmdPower(const char *args) {
+  if (strcmp(args, "reset") == 0) powerResetStats();
+  else powerPrintStats();
+}
+
+static void cmdBattery(const char *args) {
+  batteryPrint();
+}
+
+static void cmdTelemetry(const char *args) {
+  if (strcmp(args, "send") == 0) telemetryFlush();
+  else telemetryPrintStats();
+}
+
+static void cmdHelp(const char *args);
+
+static const ConsoleCommand COMMANDS[] = {
+  {"lat",   cmdLatency, "latency histograms ('lat reset' clears them)"},
+  {"stats", cmdStats,   "CPU, worst round and stack per task, tag cache and shuffle counters"},
+  {"power", cmdPower,   "time active / idle / in light sleep ('power reset' clears it)"},
+  {"batt",  cmdBattery, "filtered battery voltage, charge and state"},
+  {"tele",  cmdTelemetry, "telemetry bytes and radio time per hour ('tele send' uploads now)"},
+  {"help",  cmdHelp,    "this list"},
+};
+
+static void cmdHelp(const char *args) {
+  for (const ConsoleCommand &c : COMMANDS) Serial.printf("  %-6s %s\n", c.name, c.help);
+}
+
+static void runLine(char *text) {
+  char *args = strchr(text, ' ');
+  if (args) *args++ = '\0';
+  else args = text + strlen(text);
+
+  for (const ConsoleCommand &c : COMMANDS) {
+    if (strcmp(text, c.name) == 0) {
+      c.run(args);
+      return;
+    }
+  }
+  Serial.printf("Unknown command '%s', try 'help'\n", text);
+}
+
+void pollConsole() {
+  while (Serial.available()) {
+    char c = (char)Serial.read();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (lineLen < sizeof(line) - 1) line[lineLen++] = c;
+      continue;
+    }
+    line[lineLen] = '\0';
+    lineLen = 0;
+    if (line[0]) runLine(line);
+  }
+}
@@ -0,0 +1,58 @@
+// DFPlayer frame codec. Kept free of Arduino headers so it builds on a host too.
+#include "df_frame.h"
+
+uint16_t dfChecksum(const uint8_t *frame) {
+  // Sum of version..param_l, negated
+  uint16_t sum = 0;
+  for (uint8_t i = 1; i < 7; i++) sum += frame[i];
+  return (uint16_t)(0 - sum);
+}
+
+void dfEncodeFrame(const DFFrame &frame, uint8_t out[DF_FRAME_LEN]) {
+  out[0] = 0x7E;
+  out[1] = 0xFF;
+  out[2] = 0x06;
+  out[3] = frame.cmd;
+  out[4] = frame.feedback ? 0x01 : 0x00;
+  out[5] = frame.param >> 8;
+  out[6] = frame.param & 0xFF;
+  uint16_t chk = dfChecksum(out);
+  out[7] = chk >> 8;
+  out[8] = chk & 0xFF;
+  out[9] = 0xEF;
+}
+
+bool DFFrameDecoder::push(uint8_t b, DFFrame &out) {
+  // Hunt for the start byte
+  if (pos == 0 && b != 0x7E) {
+    framingErrors++;
+    return false;
+  }
+
+  // Fixed version/length bytes: on mismatch, resync (this byte may be a new start)
+  if ((pos == 1 && b != 0xFF) || (pos == 2 && b != 0x06)) {
+    framingErrors++;
+    pos = (b == 0x7E) ? 1 : 0;
+    if (pos) buf[0] = b;
+    return false;
+  }
+
+  buf[pos++] = b;
+  if (pos < DF_FRAME_LEN) return false;
+  pos = 0;
+
+  if (buf[9] != 0xEF) {
+    framingErrors++;
+    return false;
+  }
+  uint16_t chk = (uint16_t)(buf[7] << 8) | buf[8];
+  if (chk != dfChecksum(buf)) {
+    checksumErrors++;
+    return false;
+  }
+
+  out.cmd = buf[3];
+  out.feedback = buf[4] != 0;
+  out.param = (uint16_t)(buf[5] << 8) | buf[6];
+  return true;
+}
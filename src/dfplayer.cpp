@@ -0,0 +1,160 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "dfplayer.h"
+
+
+// ======== Setup ========
+
+// Receive-event trampoline into the driver
+static void pumpRxEvent(void *ctx) {
+  static_cast<DFPlayer *>(ctx)->pumpRx();
+}
+
+void DFPlayer::begin(SerialPort &serial, DFResponseFn onOnline) {
+  attach(serial);
+  send(DF_CMD_RESET, 0, onOnline, RESET_TIMEOUT_MS);
+}
+
+void DFPlayer::resume(SerialPort &serial) {
+  attach(serial);
+  isOnline = true;
+}
+
+void DFPlayer::attach(SerialPort &serial) {
+  port = &serial;
+  decoder.reset();
+  txHead = txTail = 0;
+  rxHead = rxTail = 0;
+  inFlight = false;
+  isOnline = false;
+
+  // Decode as bytes arrive instead of polling available() from the loop
+  port->onReceive(pumpRxEvent, this);
+}
+
+
+// ======== Commands ========
+
+bool DFPlayer::volume(uint8_t vol, DFResponseFn cb) { return send(DF_CMD_VOLUME, vol, cb); }
+bool DFPlayer::playFolder(uint8_t folder, uint8_t track, DFResponseFn cb) { return send(DF_CMD_PLAY_FOLDER, (uint16_t)(folder << 8) | track, cb); }
+bool DFPlayer::loopFolder(uint8_t folder, DFResponseFn cb) { return send(DF_CMD_LOOP_FOLDER, folder, cb); }
+bool DFPlayer::stop()                              { return send(DF_CMD_STOP, 0); }
+bool DFPlayer::next()                              { return send(DF_CMD_NEXT, 0); }
+bool DFPlayer::previous()                          { return send(DF_CMD_PREVIOUS, 0); }
+bool DFPlayer::randomAll()                         { return send(DF_CMD_RANDOM_ALL, 0); }
+bool DFPlayer::reset()                             { return send(DF_CMD_RESET, 0, nullptr, RESET_TIMEOUT_MS); }
+
+bool DFPlayer::queryVolume(DFResponseFn cb)        { return send(DF_QUERY_VOLUME, 0, cb); }
+bool DFPlayer::queryFolderFileCount(uint8_t folder, DFResponseFn cb) { return send(DF_QUERY_FOLDER_FILES, folder, cb); }
+bool DFPlayer::querySdFileCount(DFResponseFn cb)   { return send(DF_QUERY_SD_FILES, 0, cb); }
+
+// Queries are answered with their own command byte, so they don't ask for an ACK
+static bool isQuery(uint8_t cmd) {
+  return cmd >= DF_QUERY_VOLUME && cmd <= DF_QUERY_FOLDER_FILES;
+}
+
+bool DFPlayer::send(uint8_t cmd, uint16_t param, DFResponseFn cb, uint16_t timeoutMs) {
+  // Button mashing queues many volume changes; only the latest one matters
+  if (cmd == DF_CMD_VOLUME && !cb) {
+    for (uint8_t i = txTail; i != txHead; i = (i + 1) % TX_QUEUE_SIZE) {
+      if (txQueue[i].frame.cmd == DF_CMD_VOLUME && !txQueue[i].cb) {
+        txQueue[i].frame.param = param;
+        return true;
+      }
+    }
+  }
+
+  uint8_t nextHead = (txHead + 1) % TX_QUEUE_SIZE;
+  if (nextHead == txTail) {
+    txDropped++;
+    return false;
+  }
+
+  Pending &p = txQueue[txHead];
+  p.frame.cmd = cmd;
+  p.frame.param = param;
+  p.frame.feedback = !isQuery(cmd) && cmd != DF_CMD_RESET;
+  p.cb = cb;
+  p.timeoutMs = timeoutMs;
+  p.queuedUs = micros();
+  txHead = nextHead;
+  return true;
+}
+
+
+// ======== Receive path ========
+
+void DFPlayer::pumpRx() {
+  if (!port) return;
+  DFFrame f;
+  while (port->available()) {
+    if (!decoder.push((uint8_t)port->read(), f)) continue;
+    lastRx = millis();
+
+    uint8_t nextHead = (rxHead + 1) % RX_QUEUE_SIZE;
+    if (nextHead == rxTail) {
+      rxDropped++;
+      continue;
+    }
+    rxQueue[rxHead] = f;
+    rxHead = nextHead;
+  }
+}
+
+void DFPlayer::complete(bool ok, uint16_t value) {
+  inFlight = false;
+  lastQueueWait = sentUs - current.queuedUs;
+  lastRoundTrip = micros() - sentUs;
+  if (current.cb) current.cb(current.frame.cmd, ok, value);
+}
+
+void DFPlayer::dispatch(const DFFrame &f) {
+  if (f.cmd == DF_EVT_ONLINE) isOnline = true;
+
+  if (inFlight) {
+    uint8_t cmd = current.frame.cmd;
+    bool answered = (f.cmd == DF_EVT_ACK && current.frame.feedback) ||
+                    (isQuery(cmd) && f.cmd == cmd) ||
+                    (cmd == DF_CMD_RESET && f.cmd == DF_EVT_ONLINE);
+    if (answered) {
+      complete(true, f.param);
+      if (f.cmd != DF_EVT_ONLINE) return;
+    } else if (f.cmd == DF_EVT_ERROR) {
+      errors++;
+      complete(false, f.param);
+    }
+  }
+
+  if (f.cmd == DF_EVT_ACK || isQuery(f.cmd)) return; // late answers to an expired command
+  if (eventCb) eventCb(f.cmd, f.param);
+}
+
+
+// ======== Main-loop service ========
+
+void DFPlayer::service() {
+  if (!port) return;
+
+  while (rxTail != rxHead) {
+    DFFrame f = rxQueue[rxTail];
+    rxTail = (rxTail + 1) % RX_QUEUE_SIZE;
+    dispatch(f);
+  }
+
+  if (inFlight && millis() - sentAt > current.timeoutMs) {
+    timeouts++;
+    complete(false, 0);
+  }
+
+  if (!inFlight && txTail != txHead) {
+    current = txQueue[txTail];
+    txTail = (txTail + 1) % TX_QUEUE_SIZE;
+
+    uint8_t buf[DF_FRAME_LEN];
+    dfEncodeFrame(current.frame, buf);
+    port->write(buf, DF_FRAME_LEN);
+    sentAt = millis();
+    sentUs = micros();
+    inFlight = true;
+  }
+}
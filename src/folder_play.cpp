@@ -0,0 +1,268 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "folder_play.h"
+#include "hal.h"
+#include "log.h"
+#include "peripherals.h"
+#include "playback.h"
+
+// NVS layout (via the Storage HAL): the card signature, and one track count
+// per folder (index = folder number, 0 = not counted yet)
+static const char *INDEX_NAMESPACE = "folders";
+static const char *INDEX_KEY = "counts";
+static const char *SIGNATURE_KEY = "signature";
+static const uint8_t MAX_FOLDERS = 100;               // DFPlayer folders 01..99
+
+static uint8_t counts[MAX_FOLDERS];
+static uint32_t signature = 0;      // total files on the card the counts belong to
+
+static uint8_t folderPlaying = 0;   // 0 = stopped
+static uint8_t track = 0;           // playing now (or about to)
+static bool shuffled = false;
+static bool advanced = false;       // in order: `track` is one past a track that played
+static uint8_t order[255];          // shuffled: track numbers in play order
+static uint8_t orderLen = 0;        // shuffled: 0 while waiting for the folder's count
+static uint8_t position = 0;
+static uint8_t queryFolder = 0;     // folder whose 0x4E answer is outstanding
+static bool recounted = false;      // a failed track already triggered a recount
+static DFResponseFn startedFn = nullptr;
+
+static uint32_t cachedStarts = 0;
+static uint32_t countQueries = 0;
+static uint32_t tracksPlayed = 0;
+
+static void requestCount();
+static void onTrackFinished();
+
+
+// ======== Folder index ========
+
+static void saveIndex() {
+  storage.begin(INDEX_NAMESPACE, false);
+  storage.putUInt(SIGNATURE_KEY, signature);
+  storage.putBytes(INDEX_KEY, counts, sizeof(counts));
+  storage.end();
+}
+
+static void learnCount(uint8_t folder, uint8_t count) {
+  if (counts[folder] == count) return;
+  counts[folder] = count;
+  saveIndex();
+}
+
+// The card's total file count: a cheap stand-in for "is this the same card?"
+static void onSignature(uint8_t cmd, bool ok, uint16_t files) {
+  if (!ok || files == signature) return; // no answer: keep trusting the stored counts
+
+  if (signature) LOG_I("🔀 SD card changed (%u files, was %lu): folder sizes forgotten", files, (unsigned long)signature);
+  signature = files;
+  memset(counts, 0, sizeof(counts));
+  saveIndex();
+}
+
+void folderPlayBegin() {
+  storage.begin(INDEX_NAMESPACE, true);
+  signature = storage.getUInt(SIGNATURE_KEY, 0);
+  bool ok = storage.getBytesLength(INDEX_KEY) == sizeof(counts) &&
+            storage.getBytes(INDEX_KEY, counts, sizeof(counts)) == sizeof(counts);
+  storage.end();
+  if (!ok) memset(counts, 0, sizeof(counts));
+
+  player.querySdFileCount(onSignature);
+}
+
+void folderPlayCardChanged() {
+  player.querySdFileCount(onSignature);
+}
+
+
+// ======== Play order ========
+
+// Fisher-Yates over 1..count. `avoid` (the track that just played) doesn't
+// come first, so a reshuffle never repeats a track back to back.
+static void drawOrder(uint8_t count, uint8_t avoid) {
+  for (uint8_t i = 0; i < count; i++) order[i] = i + 1;
+  for (uint8_t i = count - 1; i > 0; i--) {
+    uint8_t j = random(i + 1);
+    uint8_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+  if (count > 1 && order[0] == avoid) {
+    order[0] = order[count - 1];
+    order[count - 1] = avoid;
+  }
+  orderLen = count;
+  position = 0;
+  track = order[0];
+}
+
+static void onTrackAcked(uint8_t cmd, bool ok, uint16_t value);
+
+static void playCurrent() {
+  tracksPlayed++;
+  if (shuffled) LOG_I("🔀 Folder %u: track %u (%u of %u)", folderPlaying, track, position + 1, orderLen);
+  else LOG_I("Folder %u: track %u", folderPlaying, track);
+  playbackPlayFolder(folderPlaying, track, onTrackAcked, onTrackFinished);
+}
+
+// Couldn't get a usable count: play the folder in order rather than nothing
+static void playInOrder() {
+  LOG_W("⚠️ Couldn't count the tracks in folder %u, playing it in order", folderPlaying);
+  shuffled = false;
+  advanced = false;
+  track = 1;
+  playCurrent();
+}
+
+static void onTrackAcked(uint8_t cmd, bool ok, uint16_t value) {
+  DFResponseFn fn = startedFn;
+  startedFn = nullptr;
+  if (fn) fn(cmd, ok, value);
+  if (ok || !folderPlaying) return;
+
+  if (!shuffled) {
+    if (track == 1) {
+      LOG_W("⚠️ Folder %u has nothing to play", folderPlaying);
+      folderPlaying = 0;
+      return;
+    }
+    // Past the end: after a natural advance that is the folder's size;
+    // otherwise (a stale resume point) the count can't be trusted either
+    learnCount(folderPlaying, advanced ? track - 1 : 0);
+    advanced = false;
+    track = 1;
+    playCurrent();
+    return;
+  }
+
+  // Most likely the folder changed under its cached count: count it again, once
+  if (recounted) {
+    playInOrder();
+    return;
+  }
+  LOG_W("⚠️ Folder %u track %u didn't play, recounting the folder", folderPlaying, track);
+  recounted = true;
+  counts[folderPlaying] = 0;
+  orderLen = 0;
+  requestCount();
+}
+
+
+// ======== Track counts ========
+
+static void onCountAnswered(uint8_t cmd, bool ok, uint16_t value) {
+  uint8_t folder = queryFolder;
+  queryFolder = 0;
+  if (ok && value) learnCount(folder, value > 255 ? 255 : value);
+
+  if (!folderPlaying || !shuffled || orderLen) return; // stopped or moved on meanwhile
+  if (counts[folderPlaying]) {
+    drawOrder(counts[folderPlaying], 0);
+    playCurrent();
+  } else if (folder != folderPlaying) {
+    requestCount(); // that answer was for a record taken off meanwhile
+  } else {
+    playInOrder();
+  }
+}
+
+// One query at a time: the answer doesn't say which folder it is for
+static void requestCount() {
+  if (queryFolder) return;
+  queryFolder = folderPlaying;
+  countQueries++;
+  player.queryFolderFileCount(queryFolder, onCountAnswered);
+}
+
+
+// ======== Control ========
+
+void folderPlayStart(uint8_t folder, uint8_t firstTrack, bool shuffle, DFResponseFn onStarted) {
+  if (folder == 0 || folder >= MAX_FOLDERS) {
+    folderPlayStop();
+    playbackLoopFolder(folder, onStarted);
+    return;
+  }
+
+  folderPlaying = folder;
+  shuffled = shuffle;
+  startedFn = onStarted;
+  advanced = false;
+  orderLen = 0;
+  recounted = false;
+
+  if (!shuffled) {
+    uint8_t count = counts[folder];
+    track = firstTrack >= 1 && (!count || firstTrack <= count) ? firstTrack : 1;
+    playCurrent();
+    return;
+  }
+
+  if (!counts[folder]) {
+    requestCount();
+    return;
+  }
+  cachedStarts++;
+  drawOrder(counts[folder], 0);
+  playCurrent();
+}
+
+void folderPlayStop() {
+  folderPlaying = 0;
+  orderLen = 0;
+  startedFn = nullptr;
+}
+
+bool folderPlayActive() {
+  return folderPlaying != 0;
+}
+
+uint8_t folderPlayTrack() {
+  return folderPlaying ? track : 0;
+}
+
+// The track played to its end (playback.h reports each track once)
+static void onTrackFinished() {
+  folderPlayNext();
+}
+
+void folderPlayNext() {
+  if (!folderPlaying || (shuffled && !orderLen)) return;
+
+  if (shuffled) {
+    if (++position >= orderLen) drawOrder(orderLen, track);
+    track = order[position];
+  } else {
+    // Count not known yet: a folder holds at most 255 tracks, so wrap there
+    uint8_t last = counts[folderPlaying] ? counts[folderPlaying] : 255;
+    track = track >= last ? 1 : track + 1;
+    advanced = true;
+  }
+  playCurrent();
+}
+
+void folderPlayPrevious() {
+  if (!folderPlaying || (shuffled && !orderLen)) return;
+  advanced = false;
+
+  if (shuffled) {
+    if (position) position--;
+    track = order[position];
+  } else if (track > 1) {
+    track--;
+  }
+  playCurrent();
+}
+
+
+// ======== Reporting ========
+
+void folderPlayPrintStats() {
+  uint8_t known = 0;
+  for (uint8_t i = 1; i < MAX_FOLDERS; i++) {
+    if (counts[i]) known++;
+  }
+  Serial.printf("🔀 Folders: %u counted, %lu shuffles from the index, %lu count queries, %lu tracks played\n",
+                known, (unsigned long)cachedStarts, (unsigned long)countQueries, (unsigned long)tracksPlayed);
+}
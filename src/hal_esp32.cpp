@@ -0,0 +1,217 @@
+// ESP32 implementations of the HAL interfaces (hal.h).
+// Excluded from the `native` build, which links lib/sim instead.
+
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <Adafruit_PN532.h>
+#include <Preferences.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "HardwareSerial.h"
+#include "config.h"
+#include "hal.h"
+#include "telemetry.h"
+#include "secrets.h" // defines the credentials: include it in this file only
+
+
+// ======== PN532 over bit-banged SPI ========
+
+// The PN532 library's shared packet buffer. An NTAG READ returns 16 bytes
+// (4 pages) per exchange, but ntag2xx_ReadPage() only copies out the first
+// page; the whole block is still in here (after an 8-byte frame header).
+extern uint8_t pn532_packetbuffer[];
+
+// PN532 command codes not wrapped by the library
+const uint8_t PN532_CMD_POWERDOWN = 0x16;
+const uint8_t PN532_WAKE_ON_SPI = 0x20; // PowerDown WakeUpEnable bit
+const uint8_t PN532_WAKE_MS = 2;        // SS low this long before the first command (T_osc_start)
+
+class Pn532Reader : public NfcReader {
+public:
+  Pn532Reader(Adafruit_PN532 &dev, int csPin) : pn532(dev), csPin(csPin) {}
+
+  bool begin() override { asleep = false; return pn532.begin(); }
+  uint32_t getFirmwareVersion() override { wake(); return pn532.getFirmwareVersion(); }
+  bool SAMConfig() override { wake(); return pn532.SAMConfig(); }
+  bool setPassiveActivationRetries(uint8_t maxRetries) override {
+    wake();
+    return pn532.setPassiveActivationRetries(maxRetries);
+  }
+
+  bool readPassiveTargetID(uint8_t *uid, uint8_t *uidLen, uint16_t timeoutMs) override {
+    wake();
+    return pn532.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLen, timeoutMs);
+  }
+  bool startPassiveTargetIDDetection() override {
+    wake();
+    return pn532.startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A);
+  }
+  bool readDetectedPassiveTargetID(uint8_t *uid, uint8_t *uidLen) override {
+    wake();
+    return pn532.readDetectedPassiveTargetID(uid, uidLen);
+  }
+
+  bool readPage(uint8_t page, uint8_t *buf) override {
+    wake();
+    return pn532.ntag2xx_ReadPage(page, buf);
+  }
+  bool readPages(uint8_t page, uint8_t *buf) override {
+    wake();
+    uint8_t firstPage[4];
+    if (!pn532.ntag2xx_ReadPage(page, firstPage)) return false;
+    memcpy(buf, pn532_packetbuffer + 8, 16);
+    return true;
+  }
+
+  // The status frame the PN532 posts before sleeping is left unread: the
+  // next command (SAMConfig in wake()) supersedes it.
+  bool powerDown() override {
+    if (asleep) return true;
+    uint8_t cmd[] = {PN532_CMD_POWERDOWN, PN532_WAKE_ON_SPI};
+    asleep = pn532.sendCommandCheckAck(cmd, sizeof(cmd));
+    return asleep;
+  }
+  bool poweredDown() const override { return asleep; }
+
+private:
+  // Wake sequence: hold SS low for the oscillator start-up time, then put the
+  // SAM back into normal mode before the real command goes out
+  void wake() {
+    if (!asleep) return;
+    asleep = false;
+    digitalWrite(csPin, LOW);
+    delay(PN532_WAKE_MS);
+    digitalWrite(csPin, HIGH);
+    pn532.SAMConfig();
+  }
+
+  Adafruit_PN532 &pn532;
+  int csPin;
+  bool asleep = false;
+};
+
+
+// ======== DFPlayer UART ========
+
+class HardwareSerialPort : public SerialPort {
+public:
+  HardwareSerialPort(HardwareSerial &uart, int rxPin, int txPin) : uart(uart), rxPin(rxPin), txPin(txPin) {}
+
+  void begin() override { uart.begin(9600, SERIAL_8N1, rxPin, txPin); }
+  int available() override { return uart.available(); }
+  int read() override { return uart.read(); }
+  size_t write(const uint8_t *buf, size_t len) override { return uart.write(buf, len); }
+
+  void onReceive(SerialRxFn fn, void *ctx) override {
+    uart.onReceive([fn, ctx]() { fn(ctx); }, false);
+  }
+
+private:
+  HardwareSerial &uart;
+  int rxPin;
+  int txPin;
+};
+
+
+// ======== NVS ========
+
+// The tag cache (NFC task) and the folder index (audio task) share the one
+// Preferences handle: a begin()..end() session holds it for the calling task
+class PreferencesStorage : public Storage {
+public:
+  bool begin(const char *ns, bool readOnly) override {
+    if (!lock) lock = xSemaphoreCreateRecursiveMutex();
+    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    return prefs.begin(ns, readOnly);
+  }
+  void end() override {
+    prefs.end();
+    xSemaphoreGiveRecursive(lock);
+  }
+
+  uint32_t getUInt(const char *key, uint32_t defaultValue) override { return prefs.getUInt(key, defaultValue); }
+  size_t putUInt(const char *key, uint32_t value) override { return prefs.putUInt(key, value); }
+  size_t getBytesLength(const char *key) override { return prefs.getBytesLength(key); }
+  size_t getBytes(const char *key, void *buf, size_t len) override { return prefs.getBytes(key, buf, len); }
+  size_t putBytes(const char *key, const void *buf, size_t len) override { return prefs.putBytes(key, buf, len); }
+
+private:
+  Preferences prefs;
+  SemaphoreHandle_t lock = nullptr;
+};
+
+
+// ======== Wi-Fi + MQTT ========
+
+const uint32_t MQTT_TCP_TIMEOUT_MS = 1000; // bounds the one blocking step, the broker's TCP connect
+const uint16_t MQTT_SOCKET_TIMEOUT_S = 1;  // CONNACK wait
+const uint8_t MQTT_CONNECT_TRIES = 3;
+
+class MqttLink : public TelemetryLink {
+public:
+  MqttLink() : mqtt(wifiClient) {}
+
+  void connect() override {
+    if (!clientId[0]) snprintf(clientId, sizeof(clientId), "musicbox-%06llx", ESP.getEfuseMac() & 0xFFFFFFULL);
+    wifiClient.setConnectionTimeout(MQTT_TCP_TIMEOUT_MS);
+    mqtt.setServer(mqttServer, mqttPort);
+    mqtt.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+    mqtt.setBufferSize(TELEMETRY_MAX_PAYLOAD + 128); // + topic and header
+
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(ssid, password);
+    tries = 0;
+    state = LINK_CONNECTING;
+  }
+
+  LinkState poll() override {
+    if (state == LINK_UP && !mqtt.loop()) state = LINK_FAILED; // session dropped
+    if (state != LINK_CONNECTING) return state;
+
+    wl_status_t wifi = WiFi.status();
+    if (wifi == WL_NO_SSID_AVAIL || wifi == WL_CONNECT_FAILED) return state = LINK_FAILED;
+    if (wifi != WL_CONNECTED) return state;
+
+    // One broker attempt per poll
+    if (mqtt.connect(clientId, mqttUser, mqttPassword)) state = LINK_UP;
+    else if (++tries >= MQTT_CONNECT_TRIES) state = LINK_FAILED;
+    return state;
+  }
+
+  bool publish(const char *topic, const char *payload, size_t len) override {
+    return state == LINK_UP && mqtt.publish(topic, (const uint8_t *)payload, len, false);
+  }
+
+  void disconnect() override {
+    if (mqtt.connected()) mqtt.disconnect();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    state = LINK_OFF;
+  }
+
+private:
+  WiFiClient wifiClient;
+  PubSubClient mqtt;
+  char clientId[24] = {};
+  LinkState state = LINK_OFF;
+  uint8_t tries = 0;
+};
+
+
+// ======== Peripheral instances ========
+
+static Adafruit_PN532 pn532(SPI_SCK_PIN, SPI_MISO_PIN, SPI_MOSI_PIN, SPI_CS_PIN);
+static Pn532Reader pn532Reader(pn532, SPI_CS_PIN);
+NfcReader &nfc = pn532Reader;
+
+static HardwareSerial mp3Uart(1);
+static HardwareSerialPort mp3Port(mp3Uart, UART_RX_pin, UART_TX_pin);
+SerialPort &MP3Serial = mp3Port;
+
+static PreferencesStorage nvsStorage;
+Storage &storage = nvsStorage;
+
+static MqttLink mqttLink;
+TelemetryLink &telemetryLink = mqttLink;
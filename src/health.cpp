@@ -0,0 +1,160 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "config.h"
+#include "health.h"
+#include "log.h"
+
+HealthMonitor dfplayerHealth;
+HealthMonitor readerHealth;
+
+static const char *const STATE_NAMES[] = {"healthy", "suspect", "recovering", "failed"};
+
+
+// ======== Setup ========
+
+void HealthMonitor::begin(const char *monitorName, Scheduler &scheduler, int task,
+                          const HealthHooks &monitorHooks, unsigned long silence) {
+  name = monitorName;
+  sched = &scheduler;
+  taskId = task;
+  hooks = monitorHooks;
+  silenceMs = silence;
+  schedule(CHECK_INTERVAL); // the boot bring-up gives the first answer
+}
+
+void HealthMonitor::booted(bool ok) {
+  if (ok) schedule(CHECK_INTERVAL);
+  else startRecovery(false); // it has only just failed: back off before trying again
+}
+
+
+// ======== State ========
+
+void HealthMonitor::enter(HealthState next) {
+  if (next == st) return;
+  LOG_I("🩺 %s: %s → %s", name, STATE_NAMES[st], STATE_NAMES[next]);
+  st = next;
+  entered[next]++;
+}
+
+void HealthMonitor::schedule(unsigned long ms) {
+  sched->setInterval(taskId, ms);
+}
+
+bool HealthMonitor::heardSince(unsigned long t) const {
+  return (long)(hooks.lastHeardMs() - t) >= 0;
+}
+
+
+// ======== Liveness ========
+
+// The last probe's outcome; false once it has sent the peripheral into recovery
+bool HealthMonitor::resolveProbe() {
+  probing = false;
+  if (heardSince(probeAt)) {
+    missed = 0;
+    enter(HEALTH_HEALTHY);
+    return true;
+  }
+  if (++missed >= HEALTH_PROBES) {
+    startRecovery(true);
+    return false;
+  }
+  enter(HEALTH_SUSPECT);
+  return true;
+}
+
+void HealthMonitor::check() {
+  if (st == HEALTH_RECOVERING || st == HEALTH_FAILED) {
+    if (attempting) schedule(CHECK_INTERVAL); // attemptDone() reschedules
+    else attempt();                           // the backoff is over
+    return;
+  }
+
+  if (probing && !resolveProbe()) return;
+
+  // Normal traffic says it's alive: nothing to ask
+  if (st == HEALTH_HEALTHY && millis() - hooks.lastHeardMs() <= silenceMs) {
+    schedule(CHECK_INTERVAL);
+    return;
+  }
+  if (!hooks.canProbe()) {
+    schedule(HEALTH_PROBE_TIMEOUT);
+    return;
+  }
+
+  probing = true;
+  probeAt = millis();
+  probes++;
+  hooks.probe();
+
+  if (heardSince(probeAt)) { // answered on the spot (SPI)
+    resolveProbe();
+    schedule(CHECK_INTERVAL);
+  } else {
+    schedule(HEALTH_PROBE_TIMEOUT);
+  }
+}
+
+
+// ======== Recovery ========
+
+void HealthMonitor::startRecovery(bool attemptNow) {
+  recoveryStart = millis();
+  attempts = 0;
+  backoff = HEALTH_BACKOFF_MIN;
+  probing = false;
+  missed = 0;
+  enter(HEALTH_RECOVERING);
+  if (attemptNow) {
+    attempt();
+  } else {
+    schedule(backoff);
+    backoff = min(backoff * 2, HEALTH_BACKOFF_MAX);
+  }
+}
+
+void HealthMonitor::attempt() {
+  attempting = true;
+  attempts++;
+  attemptsTotal++;
+  LOG_W("🔌 %s: reconnect attempt %u", name, attempts);
+  if (!sched->startJob(hooks.reconnect)) {
+    // No free job slot: a failed attempt, retried after the backoff
+    LOG_W("🔌 %s: no job slot for the reconnect", name);
+    attemptDone(false);
+    return;
+  }
+  schedule(CHECK_INTERVAL); // attemptDone() reschedules
+}
+
+void HealthMonitor::attemptDone(bool ok) {
+  if (!attempting) return;
+  attempting = false;
+
+  if (ok) {
+    lastRecoveryMs = millis() - recoveryStart;
+    if (lastRecoveryMs > worstRecoveryMs) worstRecoveryMs = lastRecoveryMs;
+    recoveries++;
+    enter(HEALTH_HEALTHY);
+    LOG_I("✅ %s back after %lu ms", name, lastRecoveryMs);
+    schedule(CHECK_INTERVAL);
+    if (hooks.restore) hooks.restore();
+    return;
+  }
+
+  if (attempts >= HEALTH_ATTEMPTS_BEFORE_FAILED) enter(HEALTH_FAILED);
+  LOG_W("🚫 %s still not answering, next attempt in %lu ms", name, backoff);
+  schedule(backoff);
+  backoff = min(backoff * 2, HEALTH_BACKOFF_MAX);
+}
+
+
+// ======== Reporting ========
+
+void HealthMonitor::printStats() {
+  Serial.printf("🩺 %s: %s, %lu probes, %lu suspect, %lu recovering, %lu failed, %lu attempts, %lu recoveries (last %lu ms, worst %lu ms)\n",
+                name, STATE_NAMES[st], (unsigned long)probes, (unsigned long)entered[HEALTH_SUSPECT],
+                (unsigned long)entered[HEALTH_RECOVERING], (unsigned long)entered[HEALTH_FAILED],
+                (unsigned long)attemptsTotal, (unsigned long)recoveries, lastRecoveryMs, worstRecoveryMs);
+}
@@ -0,0 +1,149 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "latency.h"
+
+const uint32_t LATENCY_BUCKET_US[LatencyHistogram::BUCKETS] = {
+  100, 200, 500,
+  1000, 2000, 5000,
+  10000, 20000, 50000,
+  100000, 200000, 500000,
+  1000000, 2000000, 5000000,
+  UINT32_MAX
+};
+
+static const char *METRIC_NAMES[LAT_COUNT] = {
+  "placement->play",
+  "removal->stop",
+  "button->volume",
+  "task round",
+  "presence check",
+  "  detect",
+  "  ndef read",
+  "  parse",
+  "  df queue",
+  "  df ack",
+};
+
+static LatencyHistogram histograms[LAT_COUNT];
+static uint32_t openedAt[LAT_COUNT];
+static bool opened[LAT_COUNT];
+
+// Paths are opened in one task and closed in another (app_tasks.h)
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+// ======== Histogram ========
+
+void LatencyHistogram::record(uint32_t us) {
+  uint8_t b = 0;
+  while (us > LATENCY_BUCKET_US[b]) b++; // last bound is UINT32_MAX
+  buckets[b]++;
+
+  if (!count || us < minUs) minUs = us;
+  if (us > maxUs) maxUs = us;
+  totalUs += us;
+  count++;
+}
+
+void LatencyHistogram::reset() {
+  *this = LatencyHistogram();
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t pct) const {
+  if (!count) return 0;
+  uint32_t want = ((uint64_t)count * pct + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < BUCKETS; b++) {
+    seen += buckets[b];
+    if (seen >= want) return b == BUCKETS - 1 ? maxUs : LATENCY_BUCKET_US[b];
+  }
+  return maxUs;
+}
+
+static void printUs(uint32_t us) {
+  if (us >= 1000000) Serial.printf("%.2f s", us / 1000000.0);
+  else if (us >= 1000) Serial.printf("%.1f ms", us / 1000.0);
+  else Serial.printf("%lu us", (unsigned long)us);
+}
+
+void LatencyHistogram::print(const char *name) const {
+  Serial.printf("%-16s n=%-5lu", name, (unsigned long)count);
+  if (!count) {
+    Serial.println();
+    return;
+  }
+
+  Serial.print(" min ");  printUs(minUs);
+  Serial.print("  avg "); printUs((uint32_t)(totalUs / count));
+  Serial.print("  p50≤"); printUs(percentileUs(50));
+  Serial.print("  p90≤"); printUs(percentileUs(90));
+  Serial.print("  max "); printUs(maxUs);
+  Serial.println();
+
+  // Only the non-empty buckets, as "≤bound:count"
+  Serial.print("                ");
+  for (uint8_t b = 0; b < BUCKETS; b++) {
+    if (!buckets[b]) continue;
+    Serial.print(" ");
+    if (b == BUCKETS - 1) Serial.print(">5 s");
+    else { Serial.print("≤"); printUs(LATENCY_BUCKET_US[b]); }
+    Serial.printf(":%lu", (unsigned long)buckets[b]);
+  }
+  Serial.println();
+}
+
+
+// ======== Paths ========
+
+void latencyRecord(LatencyMetric m, uint32_t us) {
+  if (m >= LAT_COUNT) return;
+  portENTER_CRITICAL(&lock);
+  histograms[m].record(us);
+  portEXIT_CRITICAL(&lock);
+}
+
+void latencyBegin(LatencyMetric m, uint32_t startUs) {
+  if (m >= LAT_COUNT) return;
+  portENTER_CRITICAL(&lock);
+  openedAt[m] = startUs;
+  opened[m] = true;
+  portEXIT_CRITICAL(&lock);
+}
+
+void latencyEnd(LatencyMetric m) {
+  if (m >= LAT_COUNT) return;
+  uint32_t now = micros();
+  portENTER_CRITICAL(&lock);
+  if (opened[m]) {
+    opened[m] = false;
+    histograms[m].record(now - openedAt[m]);
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void latencyCancel(LatencyMetric m) {
+  if (m >= LAT_COUNT) return;
+  portENTER_CRITICAL(&lock);
+  opened[m] = false;
+  portEXIT_CRITICAL(&lock);
+}
+
+bool latencyOpen(LatencyMetric m) {
+  return m < LAT_COUNT && opened[m];
+}
+
+
+// ======== Reporting ========
+
+void latencyPrint() {
+  Serial.printf("📊 Latency since boot or last reset (%lu s uptime)\n", millis() / 1000);
+  for (uint8_t m = 0; m < LAT_COUNT; m++) histograms[m].print(METRIC_NAMES[m]);
+}
+
+void latencyReset() {
+  portENTER_CRITICAL(&lock);
+  for (uint8_t m = 0; m < LAT_COUNT; m++) histograms[m].reset();
+  portEXIT_CRITICAL(&lock);
+  Serial.println("📊 Latency histograms cleared");
+}
@@ -0,0 +1,176 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <atomic>
+#include "log.h"
+
+struct LogRecord {
+  const char *fmt;    // doubles as the message id: the string lives in flash
+  uint32_t atMs;
+  uint8_t level;
+  uint8_t argc;
+  LogArg args[LOG_MAX_ARGS];
+};
+
+// Bounded multi-producer ring (Vyukov): a producer claims a slot with one
+// compare-and-swap on `head`, fills it, then publishes it through the slot's
+// sequence number. The single consumer (idle time) never blocks a producer.
+static const uint32_t RING_SIZE = 64; // power of two
+static const uint32_t RING_MASK = RING_SIZE - 1;
+
+struct LogSlot {
+  std::atomic<uint32_t> seq;
+  LogRecord rec;
+};
+
+static LogSlot ring[RING_SIZE];
+static std::atomic<uint32_t> head(0);
+static uint32_t tail = 0;
+
+static std::atomic<uint32_t> dropped(0);
+static uint32_t reportedDropped = 0;
+static uint32_t written = 0;
+static uint32_t worstBacklog = 0;
+
+static const char *const LEVEL_TAGS[] = {"", "E", "W", "I", "D"};
+
+
+// ======== Producers ========
+
+// Slot i starts out free for the producer that claims position i
+static struct RingInit {
+  RingInit() {
+    for (uint32_t i = 0; i < RING_SIZE; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+  }
+} ringInit;
+
+bool logPush(uint8_t level, const char *fmt, const LogArg *args, uint8_t argc) {
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  LogSlot *slot;
+  for (;;) {
+    slot = &ring[pos & RING_MASK];
+    int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed); // full: idle time hasn't come for a while
+      return false;
+    } else {
+      pos = head.load(std::memory_order_relaxed);
+    }
+  }
+
+  LogRecord &r = slot->rec;
+  r.fmt = fmt;
+  r.atMs = millis();
+  r.level = level;
+  r.argc = argc;
+  for (uint8_t i = 0; i < argc; i++) r.args[i] = args[i];
+  slot->seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+
+// ======== Formatting ========
+
+// printf with the packed arguments: each conversion is handed to snprintf on
+// its own, with the argument cast back to the type its spec expects
+static size_t formatRecord(const LogRecord &r, char *out, size_t outSize) {
+  size_t n = 0;
+  uint8_t arg = 0;
+  const char *p = r.fmt;
+
+  while (*p && n + 1 < outSize) {
+    if (*p != '%') {
+      out[n++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[n++] = '%';
+      p += 2;
+      continue;
+    }
+
+    // One conversion spec: flags, width, precision, length, conversion
+    char spec[16];
+    size_t len = 0;
+    bool isLong = false;
+    spec[len++] = *p++;
+    while (*p && !strchr("diouxXcsfFeEgGp", *p) && len < sizeof(spec) - 2) {
+      if (*p == 'l') isLong = true;
+      spec[len++] = *p++;
+    }
+    if (!*p) break;
+    char conv = *p++;
+    spec[len++] = conv;
+    spec[len] = '\0';
+
+    LogArg a = arg < r.argc ? r.args[arg] : LogArg{};
+    arg++;
+    size_t room = outSize - n;
+    int w;
+    switch (conv) {
+      case 'd': case 'i': case 'c':
+        w = isLong ? snprintf(out + n, room, spec, (long)a.i) : snprintf(out + n, room, spec, (int)a.i);
+        break;
+      case 'o': case 'u': case 'x': case 'X':
+        w = isLong ? snprintf(out + n, room, spec, (unsigned long)a.u) : snprintf(out + n, room, spec, (unsigned)a.u);
+        break;
+      case 's':
+        w = snprintf(out + n, room, spec, a.s ? a.s : "(null)");
+        break;
+      case 'p':
+        w = snprintf(out + n, room, spec, (const void *)a.s);
+        break;
+      default: // f F e E g G
+        w = snprintf(out + n, room, spec, (double)a.f);
+        break;
+    }
+    if (w < 0) break;
+    n += (size_t)w < room ? (size_t)w : room - 1;
+  }
+
+  out[n] = '\0';
+  return n;
+}
+
+
+// ======== Consumer ========
+
+bool logDrain(uint8_t maxRecords) {
+  uint32_t backlog = head.load(std::memory_order_relaxed) - tail;
+  if (backlog > worstBacklog) worstBacklog = backlog;
+
+  uint32_t lost = dropped.load(std::memory_order_relaxed);
+  if (lost != reportedDropped) {
+    Serial.printf("⚠️ %lu log lines dropped\n", (unsigned long)(lost - reportedDropped));
+    reportedDropped = lost;
+  }
+
+  char line[160];
+  for (uint8_t i = 0; i < maxRecords; i++) {
+    LogSlot &slot = ring[tail & RING_MASK];
+    if ((int32_t)(slot.seq.load(std::memory_order_acquire) - (tail + 1)) < 0) return false;
+
+    const LogRecord &r = slot.rec;
+    formatRecord(r, line, sizeof(line));
+    Serial.printf("[%lu.%03lu %s] %s\n", (unsigned long)(r.atMs / 1000), (unsigned long)(r.atMs % 1000),
+                  LEVEL_TAGS[r.level <= LOG_LEVEL_DEBUG ? r.level : 0], line);
+    written++;
+
+    slot.seq.store(tail + RING_SIZE, std::memory_order_release);
+    tail++;
+  }
+  return true;
+}
+
+void logFlush() {
+  while (logDrain(RING_SIZE)) {}
+  Serial.flush();
+}
+
+void logPrintStats() {
+  Serial.printf("📝 Log: %lu lines, worst backlog %lu of %lu, %lu dropped\n",
+                (unsigned long)written, (unsigned long)worstBacklog, (unsigned long)RING_SIZE,
+                (unsigned long)dropped.load(std::memory_order_relaxed));
+  worstBacklog = 0;
+}
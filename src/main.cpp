@@ -1,33 +1,46 @@
 // ======== Library initialization ========
 #include <Arduino.h>
-#include <DFRobotDFPlayerMini.h>
-#include <Adafruit_NeoPixel.h>
+#include "dfplayer.h"
 #include "esp32-hal-gpio.h"
+#include "hal.h"
 #include "peripherals.h"
 #include "config.h"
 #include "helpers.h"
-#include "tag_parser.h"
+#include "app_state.h"
+#include "app_tasks.h"
+#include "buttons.h"
+#include "tag_cache.h"
+#include "nfc_detect.h"
+#include "power.h"
+#include "status_led.h"
+#include "battery.h"
+#include "boot.h"
+#include "telemetry.h"
+#include "playback.h"
 
 // using namespace std;
 
+static bool dfplayerBusy();
+static bool recordPlaying();
+static bool buttonHeld();
+static bool audioPlaying();
+
 
 void setup() {
 
   // Init USB serial port for debugging
-  Serial.begin(9600);
+  Serial.begin(115200);
+  bootMark("setup");
 
-  // Initialize status light
-  pinMode(StatusLight_R_Pin, OUTPUT);
-  pinMode(StatusLight_G_Pin, OUTPUT);
-  pinMode(StatusLight_B_Pin, OUTPUT);
+  // Initialize status light (LEDC, status_led.h)
+  statusLedBegin();
 
   // Show booting up with dim yellow
   setStatusLight(10, 5, 0);
   
 
-  // Initialize buttons
-  pinMode(Button1_pin, INPUT);
-  pinMode(Button2_pin, INPUT);
+  // Initialize buttons: edges are queued from here on, the UI task acts on them
+  buttonsBegin();
 
   // initialize power switch
   pinMode(Switch_pin, INPUT_PULLUP);
@@ -39,217 +52,72 @@ void setup() {
     esp_deep_sleep_start();
   }
 
-  // Do a check of battery status on bootup
-  checkBatteryAndSleepIfLow();
-
-  // ----------- Initialize MP3 UART connection ------------------
-  bool DFRobot_connected = false; // little check for the MP3 player connection
-
-  MP3Serial.begin(9600, SERIAL_8N1, /*rx*/ 17, /*tx*/ 16); 
-  delay(250);
-  unsigned long t0 = millis();
-  while (millis() - t0 < 2000) {
-    if (MP3Serial.available()) Serial.printf("Got: 0x%02X\n", MP3Serial.read());
+  // ----------- Battery ------------------
+  // A wake from the low-battery sleep only carries on once the battery has
+  // recovered past WAKE_BAT_THRESHOLD; otherwise straight back to sleep
+  bool lowBatteryWake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+  batteryBegin(lowBatteryWake, audioPlaying);
+  if (batteryState() == BATT_LOW && lowBatteryWake) {
+    Serial.printf("🪫 Battery still at %.2f V (needs %.2f V) — not waking up.\n", batteryVolts(), WAKE_BAT_THRESHOLD);
+    lowBatterySleep();
   }
 
+  // ----------- Peripherals ------------------
+  // Nothing waits here: the audio task resets the DFPlayer while the NFC task
+  // brings up the PN532, and the status light stays yellow until both have
+  // answered (boot.h). A wake from the low-battery sleep skips both.
+  bootBegin(lowBatteryWake);
 
-  if (!player.begin(MP3Serial)) {
-    Serial.println("❌ Connecting to DFPlayer Mini failed!");
-    Serial.println("Check wiring, SD card, and voltage levels.");
-    setStatusLight(0, 10, 10); 
-
-    DFRobot_connected = false; 
+  nfcDetectBegin();
 
-  } 
-
-  DFRobot_connected = true; 
-
-  Serial.println("DFRobot player connected!");
-
-  
-  
+  telemetryEvent(TEL_BOOT, esp_sleep_get_wakeup_cause(), (int16_t)(batteryVolts() * 1000));
 
-  // ----------- Initialize NFC reader ------------------
-  nfc.begin();
-  uint32_t versiondata = nfc.getFirmwareVersion();
-  bool NFCconnected = false;
-  if (!versiondata) {
-    Serial.println("Didn't find PN53x board");
+  // Known records, so re-placements skip the NDEF read
+  tagCache.begin();
 
-    setStatusLight(10, 0, 10);
+  // --------- Everything from here on runs in the app tasks ---------
+  audioTaskBegin();
+  uiTaskBegin();
+  nfcTaskBegin();
+  bootMark("tasks started");
 
-  } else {
-    NFCconnected = true;
-    Serial.println("PN532 connected!");
-    nfc.SAMConfig();
-  }
+  // --------- Light sleep between events ---------
+  powerAddVeto("dfplayer", dfplayerBusy);
+  powerAddVeto("playback", recordPlaying);
+  powerAddVeto("button", buttonHeld);
+  powerAddVeto("telemetry", telemetryActive); // Wi-Fi drops in light sleep
+  powerBegin();
 
-  
-  // --------- Final check, update status light if ready--------- 
-  checkPeripherals();
-  if (DFRobot_connected && NFCconnected) {
-    setStatusLight(0, 5, 0);  // green = all good
-
-    // Play removed chime then stop playback
-    player.volume(10);
-    player.playFolder(01,001);
-
-    // Instead of hard/blocking delay, soft yield
-    unsigned long chimeStart = millis();
-    while (millis() - chimeStart < 2000) {
-      yield(); // feed OS/wdt so we won't panic
-    }
-
-    player.volume(volume);
-    player.stop();
-  }
-  
+  appTasksStart();
 }
 
 void loop() {
+  // The audio, UI and NFC tasks do the work (app_tasks.h); this only runs
+  // when they are all waiting, and idles or light-sleeps until the next deadline
+  appTasksLoop();
+}
 
-  pinMode(Switch_pin, INPUT_PULLUP);
-  bool switchOn = (digitalRead(Switch_pin) == LOW);
-
-
-  // Check battery levels, put to sleep if not charged sufficiently
-  checkBatteryAndSleepIfLow();
-
-  // Check for button presses, perform actions
-  handleButtonAction();
-
-  // Wait for a card
-  boolean success;
-  uint8_t uid[7];
-  uint8_t uidLen = 0;
-  static unsigned long lastCooldown = 0;
-
-  // 
-  if (millis() - lastNfcCheck >= nfcInterval) {
-
-    checkPeripherals();
-    
-    lastNfcCheck = millis();
-
-    Serial.println("Waiting for a tag... (tap now)");
-
-    bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLen, 50);
-
-    // If tag detected, build new string for comparison with global
-    if (success) {
-
-      // Change status light to show playing
-      setStatusLight(0, 0, 5); 
-
-      // update last seen time
-      lastTagSeen = millis();
-
-      // If new tag detected 
 
-      bool newTag = !tagPresent || (uidLen != currentUIDLength) || (memcmp(uid, currentUID, uidLen) != 0);
+// ---- Sleep vetoes (power.h) ----
+// The UART sleeps with the CPU: stay up until the module has answered,
+// and until its BUSY line says whether the audio started
+static bool dfplayerBusy() {
+  return !player.idle() || playbackState() == PLAYBACK_STARTING;
+}
 
-      if (newTag) {
+// Track-finished and error frames must not be lost while anything plays: a
+// record, or a chime waiting on its finish frame. With BUSY wired, the line
+// rising at the end of the track wakes the CPU.
+static bool recordPlaying() {
+  return DF_BUSY_pin < 0 && playbackState() != PLAYBACK_STOPPED;
+}
 
-        player.volume(volume);
-  
-        tagPresent = true;
-        memcpy(currentUID, uid, uidLen);
-        currentUIDLength = uidLen;
-        hasPlayedForCurrentTag = false;  // allow playback for this tag
-
-        // Print UID as hex
-        Serial.print("Current UID: ");
-        for (uint8_t i = 0; i < currentUIDLength; i++) {
-          if (currentUID[i] < 0x10) Serial.print("0"); // leading zero
-          Serial.print(currentUID[i], HEX);
-        }
-        Serial.println();
-
-      } 
-
-      // Here could be where I map the records to their respective files...
-      // For now, just pulling the folder from the payload and playing.
-      // Attempt to read NDEF text payload
-      // Triggers playback only once per tag reading
-      if (!hasPlayedForCurrentTag) {
-        String payload = readNdefTextFromTag();
-        if (payload.length() == 0) {
-          Serial.println("No NDEF text found (or read failed). Ensure tag is NDEF formatted and contains a Text record.");
-          // Change status light to show removed 
-          setStatusLight(10, 0, 0); 
-
-        } else {
-          Serial.print("NDEF text payload: '");
-          Serial.print(payload);
-          Serial.println("'");
-
-          // Parse the tag payload for folder, track, volume, shuffle
-          TagCommand cmd = parseTagPayload(payload);
-
-          if (cmd.valid) {
-            Serial.printf("Parsed tag: folder=%u, track=%u, volume=%d, shuffle=%s\n",
-                          cmd.folder, cmd.track, cmd.volume, cmd.shuffle ? "yes" : "no");
-
-            // Set volume if specified
-            if (cmd.volume >= 0) {
-              volume_boost = cmd.volume;
-              Serial.printf("Changing volume by %d to a total of %d\n", cmd.volume, min(volume + cmd.volume, 30));
-              player.volume(min(volume + cmd.volume, 30));
-              volume = volume + cmd.volume;
-            }
-
-            // Enable shuffle if specified
-            if (cmd.shuffle) {
-              Serial.println("Shuffle enabled");
-              player.randomAll();
-            }
-
-            // Play the track
-            Serial.printf("Playing folder %u.\n", cmd.folder);
-            player.loopFolder(cmd.folder);
-            hasPlayedForCurrentTag = true;
-          } else {
-            Serial.println("Failed to parse tag payload.");
-            setStatusLight(10, 0, 0);
-          }
-        }
-      }
-
-    } else {
-
-      // No tag read this iteration: check timeout to decide removal
-      if (tagPresent && millis() - lastTagSeen > TAG_TIMEOUT) {
-        tagPresent = false;
-        hasPlayedForCurrentTag = false;  // reset so next tag triggers playback
-        Serial.println("Tag removed - stopping playback");
-
-        // Change status light to show removed 
-        setStatusLight(0, 5, 0); 
-
-        // Play removed chime at fixed volume (always 10)
-        player.volume(10);
-        player.playFolder(01, 002);
-        
-        // Instead of hard/blocking delay, soft yield
-        unsigned long chimeStart = millis();
-        while (millis() - chimeStart < 2500) {
-          yield(); // feed OS/wdt so we won't panic
-        }
-
-        // Restore the volume setting (from tag or default)
-        volume = volume - volume_boost; // remove volume boost
-        player.volume(volume);
-        player.stop();
-
-
-        // Clear UID state
-        currentUIDLength = 0;
-        memset(currentUID, 0, sizeof(currentUID));
-      }
-    }
-    
-  }
+// A held button would wake the CPU straight away again
+static bool buttonHeld() {
+  return digitalRead(Button1_pin) == LOW || digitalRead(Button2_pin) == LOW;
+}
 
-  // Short delay to prevent busy-looping
-  delay(10);
+// The amplifier's draw pulls the battery down while anything plays (battery.h)
+static bool audioPlaying() {
+  return playbackState() != PLAYBACK_STOPPED;
 }
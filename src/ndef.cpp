@@ -0,0 +1,279 @@
+// Streaming NDEF decoder. Kept free of Arduino headers so it builds on a host too.
+#include <string.h>
+#include "ndef.h"
+
+// TLV tags (NFC Forum Type 2 Tag)
+static const uint8_t TLV_NULL = 0x00;
+static const uint8_t TLV_NDEF = 0x03;
+static const uint8_t TLV_TERMINATOR = 0xFE;
+
+// Record header flags
+static const uint8_t NDEF_ME = 0x40;
+static const uint8_t NDEF_CF = 0x20;
+static const uint8_t NDEF_SR = 0x10;
+static const uint8_t NDEF_IL = 0x08;
+
+static const uint8_t TNF_WELL_KNOWN = 0x01;
+static const uint8_t TNF_MIME = 0x02;
+static const uint8_t TNF_UNCHANGED = 0x06;
+
+// URI record prefix codes (NFC Forum URI RTD)
+static const char *const URI_PREFIXES[] = {
+  "", "http://www.", "https://www.", "http://", "https://", "tel:", "mailto:",
+  "ftp://anonymous:anonymous@", "ftp://ftp.", "ftps://", "sftp://", "smb://",
+  "nfs://", "ftp://", "dav://", "news:", "telnet://", "imap:", "rtsp://", "urn:",
+  "pop:", "sip:", "sips:", "tftp:", "btspp://", "btl2cap://", "btgoep://",
+  "tcpobex://", "irdaobex://", "file://", "urn:epc:id:", "urn:epc:tag:",
+  "urn:epc:pat:", "urn:epc:raw:", "urn:epc:", "urn:nfc:",
+};
+static const uint8_t URI_PREFIX_COUNT = sizeof(URI_PREFIXES) / sizeof(URI_PREFIXES[0]);
+
+
+void NdefDecoder::begin(char *outBuf, size_t outBufSize, uint8_t wantMask) {
+  *this = NdefDecoder();
+  out = outBuf;
+  outSize = outBufSize;
+  want = wantMask;
+  if (outSize) out[0] = '\0';
+}
+
+NdefStatus NdefDecoder::push(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len && state == NDEF_MORE; i++) {
+    state = feed(data[i]);
+    offset++;
+  }
+  return state;
+}
+
+
+// ======== TLV layer ========
+
+NdefStatus NdefDecoder::startTlvValue() {
+  if (tlvTag == TLV_NDEF) {
+    if (tlvLeft == 0) return NDEF_NOT_FOUND; // empty message
+    step = REC_HEADER;
+  } else {
+    step = tlvLeft ? TLV_SKIP : TLV_TAG;
+  }
+  return NDEF_MORE;
+}
+
+NdefStatus NdefDecoder::feed(uint8_t b) {
+  switch (step) {
+    case TLV_TAG:
+      if (b == TLV_NULL) return NDEF_MORE;
+      if (b == TLV_TERMINATOR) return NDEF_NOT_FOUND;
+      tlvTag = b;
+      step = TLV_LEN;
+      return NDEF_MORE;
+
+    case TLV_LEN:
+      if (b == 0xFF) {              // 3-byte length follows
+        step = TLV_LEN_EXT_HI;
+        return NDEF_MORE;
+      }
+      tlvLeft = b;
+      return startTlvValue();
+
+    case TLV_LEN_EXT_HI:
+      tlvLeft = (uint16_t)(b << 8);
+      step = TLV_LEN_EXT_LO;
+      return NDEF_MORE;
+
+    case TLV_LEN_EXT_LO:
+      tlvLeft |= b;
+      return startTlvValue();
+
+    case TLV_SKIP:
+      if (--tlvLeft == 0) step = TLV_TAG;
+      return NDEF_MORE;
+
+    default:
+      break;
+  }
+
+  // ---- Inside the NDEF message TLV: every record byte counts against it ----
+  if (tlvLeft == 0) return NDEF_ERROR;   // record runs past the TLV
+  tlvLeft--;
+
+  switch (step) {
+    case REC_HEADER: {
+      header = b;
+      uint8_t tnf = header & 0x07;
+      // Continuation chunks must say "unchanged", and nothing else may
+      if (chunked != (tnf == TNF_UNCHANGED)) return NDEF_ERROR;
+      step = REC_TYPE_LEN;
+      return NDEF_MORE;
+    }
+
+    case REC_TYPE_LEN:
+      typeLen = b;
+      payloadLen = 0;
+      lenBytes = 0;
+      step = REC_PAYLOAD_LEN;
+      return NDEF_MORE;
+
+    case REC_PAYLOAD_LEN:
+      payloadLen = (payloadLen << 8) | b;
+      if (!(header & NDEF_SR) && ++lenBytes < 4) return NDEF_MORE;
+      idLen = 0;
+      if (header & NDEF_IL) {
+        step = REC_ID_LEN;
+        return NDEF_MORE;
+      }
+      step = REC_TYPE;
+      fieldLeft = typeLen;
+      typeHave = 0;
+      return nextField();
+
+    case REC_ID_LEN:
+      idLen = b;
+      step = REC_TYPE;
+      fieldLeft = typeLen;
+      typeHave = 0;
+      return nextField();
+
+    case REC_TYPE:
+      if (typeHave < sizeof(type) - 1) type[typeHave++] = (char)b;
+      fieldLeft--;
+      return nextField();
+
+    case REC_ID:
+      fieldLeft--;
+      return nextField();
+
+    case REC_PAYLOAD:
+      if (capturing) {
+        payloadByte(b);
+        // Output is full: the rest of the record can't change the result
+        if (rec.truncated) {
+          if (outSize) out[rec.length] = '\0';
+          return NDEF_DONE;
+        }
+      }
+      fieldLeft--;
+      return nextField();
+
+    default:
+      return NDEF_ERROR;
+  }
+}
+
+
+// ======== Record layer ========
+
+NdefStatus NdefDecoder::nextField() {
+  if (step == REC_TYPE && fieldLeft == 0) {
+    typeDone();
+    step = REC_ID;
+    fieldLeft = idLen;
+  }
+  if (step == REC_ID && fieldLeft == 0) {
+    step = REC_PAYLOAD;
+    fieldLeft = payloadLen;
+  }
+  if (step == REC_PAYLOAD && fieldLeft == 0) return endRecord();
+  return NDEF_MORE;
+}
+
+// The type is known: decide whether this record is the one to keep
+void NdefDecoder::typeDone() {
+  if (chunked) return; // continuation of the series decided at its first chunk
+
+  type[typeHave] = '\0';
+  uint8_t tnf = header & 0x07;
+  NdefRecordType t = NDEF_RECORD_NONE;
+  if (tnf == TNF_WELL_KNOWN && typeLen == 1 && type[0] == 'T') t = NDEF_RECORD_TEXT;
+  else if (tnf == TNF_WELL_KNOWN && typeLen == 1 && type[0] == 'U') t = NDEF_RECORD_URI;
+  else if (tnf == TNF_MIME) t = NDEF_RECORD_MIME;
+
+  capturing = (t & want) != 0;
+  if (!capturing) return;
+
+  rec.type = t;
+  if (t == NDEF_RECORD_MIME) {
+    strncpy(rec.mimeType, type, sizeof(rec.mimeType) - 1);
+    rec.mimeType[sizeof(rec.mimeType) - 1] = '\0';
+  }
+  payloadPos = 0;
+}
+
+NdefStatus NdefDecoder::endRecord() {
+  bool more = header & NDEF_CF;
+
+  if (capturing && !more) {
+    if (outSize) out[rec.length] = '\0';
+    return NDEF_DONE;
+  }
+
+  chunked = more;
+  if (header & NDEF_ME) return more ? NDEF_ERROR : NDEF_NOT_FOUND;
+  if (tlvLeft == 0) return more ? NDEF_ERROR : NDEF_NOT_FOUND; // no ME flag: tolerate
+
+  step = REC_HEADER;
+  return NDEF_MORE;
+}
+
+void NdefDecoder::payloadByte(uint8_t b) {
+  uint32_t pos = payloadPos++;
+
+  switch (rec.type) {
+    case NDEF_RECORD_TEXT: {
+      // [status: UTF-16 flag | language length][language][text]
+      if (pos == 0) {
+        utf16 = b & 0x80;
+        langLen = b & 0x3F;
+        return;
+      }
+      if (pos <= langLen) {
+        size_t i = pos - 1;
+        if (i < sizeof(rec.lang) - 1) {
+          rec.lang[i] = (char)b;
+          rec.lang[i + 1] = '\0';
+        }
+        return;
+      }
+      if (!utf16) {
+        emit((char)b);
+        return;
+      }
+
+      // UTF-16: big endian unless a byte order mark says otherwise; only
+      // ASCII survives, the rest becomes '?'
+      uint32_t textPos = pos - 1 - langLen;
+      if (textPos % 2 == 0) {
+        utf16First = b;
+        return;
+      }
+      uint16_t unit = utf16Le ? (uint16_t)(b << 8 | utf16First) : (uint16_t)(utf16First << 8 | b);
+      if (textPos == 1 && unit == 0xFEFF) return;
+      if (textPos == 1 && unit == 0xFFFE) {
+        utf16Le = true;
+        return;
+      }
+      emit(unit < 0x80 ? (char)unit : '?');
+      return;
+    }
+
+    case NDEF_RECORD_URI:
+      if (pos == 0) {
+        if (b < URI_PREFIX_COUNT) emitString(URI_PREFIXES[b]);
+        return;
+      }
+      emit((char)b);
+      return;
+
+    default:
+      emit((char)b);
+      return;
+  }
+}
+
+void NdefDecoder::emit(char c) {
+  if (rec.length + 1 < outSize) out[rec.length++] = c;
+  else rec.truncated = true;
+}
+
+void NdefDecoder::emitString(const char *s) {
+  while (*s) emit(*s++);
+}
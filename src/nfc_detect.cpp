@@ -0,0 +1,80 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "hal.h"
+#include "peripherals.h"
+#include "config.h"
+#include "nfc_detect.h"
+
+static volatile bool irqFired = false;
+static volatile uint32_t irqAtUs = 0;
+static bool armed = false;
+static unsigned long lastArmFailure = 0;
+static bool armFailed = false;
+static bool retryForever = false; // the PN532 is set up for a detection, not a poll
+
+static void IRAM_ATTR onNfcIrq() {
+  irqAtUs = micros();
+  irqFired = true;
+}
+
+void nfcDetectBegin() {
+  if (!nfcIrqWired()) {
+    Serial.println("PN532 IRQ not wired — polling for tags at an adaptive cadence");
+    return;
+  }
+  pinMode(NFC_IRQ_pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(NFC_IRQ_pin), onNfcIrq, FALLING);
+}
+
+bool nfcIrqWired() {
+  return NFC_IRQ_pin >= 0;
+}
+
+void nfcSetPollRetries() {
+  nfc.setPassiveActivationRetries(NFC_POLL_ACTIVATION_RETRIES);
+  retryForever = false; // a dead reader is left to the health monitor's reconnect
+}
+
+bool nfcDetectArmed() {
+  return armed;
+}
+
+void nfcDisarm() {
+  armed = false;
+  if (retryForever) nfcSetPollRetries(); // also aborts the pending detection
+}
+
+bool nfcArmDetection() {
+  if (!nfcIrqWired()) return false;
+  if (armed) return true;
+  if (armFailed && millis() - lastArmFailure < NFC_REARM_BACKOFF) return false;
+
+  // Keep looking until a tag shows up instead of timing out after a few tries
+  nfc.setPassiveActivationRetries(0xFF);
+  retryForever = true;
+  armed = nfc.startPassiveTargetIDDetection();
+  irqFired = false; // the command's ACK also pulls IRQ low; only the response counts
+
+  armFailed = !armed;
+  if (armFailed) lastArmFailure = millis();
+  return armed;
+}
+
+uint32_t nfcDetectedAtUs() {
+  return irqAtUs;
+}
+
+bool nfcTagDetected(uint8_t *uid, uint8_t *uidLen) {
+  if (!armed) return false;
+
+  // IRQ stays low until the response is read, so the level also catches an
+  // edge that landed before irqFired was cleared
+  if (!irqFired && digitalRead(NFC_IRQ_pin) != LOW) return false;
+  if (!irqFired) irqAtUs = micros();
+
+  irqFired = false;
+  armed = false;
+  bool read = nfc.readDetectedPassiveTargetID(uid, uidLen);
+  nfcSetPollRetries(); // the presence checks that follow are one-shot polls
+  return read;
+}
@@ -0,0 +1,29 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "config.h"
+#include "nfc_poll.h"
+
+static unsigned long burstStart = 0;
+static bool burst = false;
+static unsigned long idleInterval = 0;
+
+void nfcPollBurst() {
+  burstStart = millis();
+  burst = true;
+  idleInterval = NFC_POLL_FAST_INTERVAL;
+}
+
+unsigned long nfcPollNextInterval(bool tagPresent) {
+  if (tagPresent) {
+    burst = false; // the record arrived; the next window opens on removal
+    return NFC_PRESENCE_INTERVAL;
+  }
+
+  if (burst && millis() - burstStart < NFC_POLL_FAST_WINDOW) return NFC_POLL_FAST_INTERVAL;
+  burst = false;
+
+  // Back off in steps toward the idle rate
+  if (idleInterval < NFC_POLL_FAST_INTERVAL) idleInterval = NFC_POLL_FAST_INTERVAL;
+  idleInterval = min((unsigned long)(idleInterval * NFC_POLL_BACKOFF), nfcInterval);
+  return idleInterval;
+}
@@ -0,0 +1,412 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "app_state.h"
+#include "app_tasks.h"
+#include "boot.h"
+#include "config.h"
+#include "hal.h"
+#include "health.h"
+#include "helpers.h"
+#include "latency.h"
+#include "log.h"
+#include "nfc_detect.h"
+#include "nfc_poll.h"
+#include "peripherals.h"
+#include "tag_cache.h"
+#include "tag_parser.h"
+
+// NFC task: everything that talks to the PN532. It decides what is on the
+// reader and tells the audio task through tagEvents (app_state.h); it never
+// touches the player.
+
+static TagCommand sentCmd = {0, 1, -1, false, false}; // what the audio task was told to play
+static int nfcPollTask = -1;
+static int nfcIrqTask = -1;
+static bool missing = false;          // the present tag missed a poll...
+static uint32_t missStartUs = 0;      // ...starting here (removal latency path)
+static bool unreadableSent = false;   // once per placement, not once per poll
+static unsigned long readerLastHeard = 0; // last time the PN532 answered: a tag read, or a probe
+
+// Whether the present tag answers the presence check's page READ. NTAG and
+// Ultralight do; other types (MIFARE Classic, ISO-DEP) refuse it every time.
+enum PageRead : uint8_t { PAGE_READ_UNKNOWN, PAGE_READ_WORKS, PAGE_READ_REFUSED };
+static PageRead pageRead = PAGE_READ_UNKNOWN;
+
+static void pollNfc();
+static void checkNfcIrq();
+static void nfcHealthTask();
+static void handleTagPoll(bool success, const uint8_t *uid, uint8_t uidLen, uint32_t detectStartUs);
+static void updateNfcMode();
+static bool readTagCommand(TagCommand &cmd);
+static uint32_t verifyCachedTagJob(uint8_t stage);
+static uint32_t nfcBootJob(uint8_t stage);
+static void reportReaderHealth();
+static unsigned long readerLastHeardMs();
+static bool readerCanProbe();
+static void readerProbe();
+static uint32_t readerReconnectJob(uint8_t stage);
+static void readerRestore();
+
+
+void nfcTaskBegin() {
+  // Detection starts when the bring-up job is done with the reader
+  nfcPollTask = nfcScheduler.addTask("nfc", pollNfc, NFC_POLL_FAST_INTERVAL);
+  nfcScheduler.setEnabled(nfcPollTask, false);
+  if (nfcIrqWired()) {
+    nfcIrqTask = nfcScheduler.addTask("nfc irq", checkNfcIrq, NFC_IRQ_CHECK_INTERVAL);
+    nfcScheduler.setEnabled(nfcIrqTask, false);
+    nfcScheduler.setSleepable(nfcIrqTask, true); // PN532 IRQ wakes
+  }
+  int healthTask = nfcScheduler.addTask("nfc health", nfcHealthTask, CHECK_INTERVAL);
+  readerHealth.begin("PN532", nfcScheduler, healthTask,
+                     {readerLastHeardMs, readerCanProbe, readerProbe, readerReconnectJob, readerRestore}, NFC_SILENCE_TIMEOUT);
+  nfcScheduler.startJob(nfcBootJob);
+}
+
+// The reader is up (or given up on for now): start looking for tags
+static uint32_t nfcBootDone(bool ok, const char *phase) {
+  if (ok) readerLastHeard = millis();
+  readerHealth.booted(ok);
+  nfcOK = readerHealth.ok();
+  bootMark(phase);
+
+  nfcScheduler.setEnabled(nfcPollTask, true);
+  nfcPollBurst(); // someone just switched the box on: a tag is probably coming
+  if (nfcIrqWired()) {
+    nfcScheduler.setEnabled(nfcIrqTask, true);
+    updateNfcMode();
+  }
+  bootMark("tag detection started");
+  reportReaderHealth();
+  return JOB_DONE;
+}
+
+// PN532 bring-up, while the DFPlayer resets. After a wake from the
+// low-battery sleep the reader is still configured and only needs waking;
+// otherwise probe until NFC_BOOT_TIMEOUT. The health check picks up a reader
+// that answers later.
+static uint32_t nfcBootJob(uint8_t stage) {
+  static unsigned long startMs = 0;
+  if (stage == 0) {
+    startMs = millis();
+    nfc.begin();
+    if (bootResumed() && nfc.SAMConfig()) {
+      nfcSetPollRetries(); // it may have gone to sleep armed
+      return nfcBootDone(true, "PN532 resumed");
+    }
+  }
+
+  if (nfc.getFirmwareVersion()) {
+    nfc.SAMConfig();
+    nfcSetPollRetries();
+    LOG_I("PN532 connected!");
+    return nfcBootDone(true, "PN532 ready");
+  }
+  if (millis() - startMs < NFC_BOOT_TIMEOUT) return NFC_BOOT_RETRY_INTERVAL;
+
+  LOG_E("Didn't find PN53x board");
+  return nfcBootDone(false, "PN532 not found");
+}
+
+static void sendTag(TagEventType type, const TagCommand &cmd, uint32_t startUs, bool fromCache = false) {
+  TagEvent e = {};
+  e.type = type;
+  memcpy(e.uid, currentUID, sizeof(e.uid));
+  e.uidLen = currentUIDLength;
+  e.cmd = cmd;
+  e.startUs = startUs;
+  e.fromCache = fromCache;
+  e.ok = true;
+  sendTagEvent(e);
+}
+
+// The UID as one log record: 4 or 7 bytes, packed big-endian into two words
+static void logUid() {
+  uint32_t hi = 0, lo = 0;
+  for (uint8_t i = 0; i < currentUIDLength; i++) {
+    hi = (hi << 8) | (lo >> 24);
+    lo = (lo << 8) | currentUID[i];
+  }
+  if (currentUIDLength > 4) LOG_I("Current UID: %06lX%08lX", hi, lo);
+  else LOG_I("Current UID: %08lX", lo);
+}
+
+
+// ---- Supervision (health.h) ----
+// Tag reads and presence checks are signs of life; an empty field isn't one
+static unsigned long readerLastHeardMs() {
+  return readerLastHeard;
+}
+
+// A tag on the reader is read every NFC_PRESENCE_INTERVAL anyway
+static bool readerCanProbe() {
+  return !tagPresent;
+}
+
+static void readerProbe() {
+  nfcDisarm(); // the probe aborts a pending IRQ detection; it's re-armed afterwards
+  if (nfc.getFirmwareVersion()) readerLastHeard = millis();
+}
+
+// Split into stages so the PN532's wake-up doesn't stall the task
+static uint32_t readerReconnectJob(uint8_t stage) {
+  switch (stage) {
+    case 0:
+      nfcDisarm();
+      nfc.begin();
+      return 100;
+    default: {
+      bool ok = nfc.getFirmwareVersion() != 0;
+      if (ok) {
+        nfc.SAMConfig();
+        nfcSetPollRetries();
+        readerLastHeard = millis();
+      }
+      readerHealth.attemptDone(ok);
+      nfcOK = readerHealth.ok();
+      reportReaderHealth();
+      return JOB_DONE;
+    }
+  }
+}
+
+// A record left on the box is read again straight away, and resumes (resume.h)
+static void readerRestore() {
+  nfcPollBurst();
+  nfcScheduler.runSoon(nfcPollTask);
+  updateNfcMode();
+}
+
+// Reschedules itself (health.h); the audio task folds the result into the box state
+static void nfcHealthTask() {
+  bool wasOK = nfcOK;
+  readerHealth.check();
+  nfcOK = readerHealth.ok();
+  if (nfcOK != wasOK) reportReaderHealth();
+}
+
+static void reportReaderHealth() {
+  TagEvent e = {};
+  e.type = TAG_READER_HEALTH;
+  e.ok = nfcOK;
+  sendTagEvent(e);
+}
+
+
+// Here could be where I map the records to their respective files...
+// For now, just pulling the folder from the payload and playing.
+// Reads and parses the NDEF text payload; returns false if there was none.
+static bool readTagCommand(TagCommand &cmd) {
+  char payload[256];
+  uint32_t start = micros();
+  size_t payloadLen = readNdefTextFromTag(payload, sizeof(payload));
+  latencyRecord(LAT_NDEF_READ, micros() - start);
+  if (payloadLen == 0) return false;
+
+  // The payload is a stack buffer, which a deferred record can't point at:
+  // its size is logged here and what it says once parsed
+  LOG_D("NDEF text payload, %u bytes", (unsigned)payloadLen);
+
+  // Parse the tag payload for folder, track, volume, shuffle
+  start = micros();
+  cmd = parseTagPayload(payload, payloadLen);
+  latencyRecord(LAT_PARSE, micros() - start);
+  if (cmd.valid) {
+    LOG_I("Parsed tag: folder=%u, track=%u, volume=%d, shuffle=%s",
+          cmd.folder, cmd.track, cmd.volume, cmd.shuffle ? "yes" : "no");
+  }
+  return true;
+}
+
+// Runs after a cache hit has already started playback: re-read the NDEF and,
+// if the tag was rewritten, fix the cache and switch to the new command
+static uint32_t verifyCachedTagJob(uint8_t stage) {
+  if (!tagPresent) return JOB_DONE;
+
+  TagCommand fresh;
+  if (!readTagCommand(fresh)) return JOB_DONE; // read failed: can't tell, keep the entry
+
+  if (!fresh.valid) {
+    tagCache.stale++;
+    tagCache.invalidate(currentUID, currentUIDLength);
+    return JOB_DONE;
+  }
+  if (sameTagCommand(fresh, sentCmd)) return JOB_DONE;
+
+  LOG_I("Tag was rewritten, updating cache");
+  tagCache.stale++;
+  tagCache.store(currentUID, currentUIDLength, fresh);
+
+  sentCmd = fresh;
+  sendTag(TAG_REWRITTEN, fresh, micros());
+  return JOB_DONE;
+}
+
+
+// With the IRQ wired, the timed poll only runs while a tag is present (to
+// notice its removal); otherwise the PN532 waits for a tag on its own
+static void updateNfcMode() {
+  if (!nfcIrqWired()) return;
+  nfcScheduler.setEnabled(nfcPollTask, tagPresent);
+  if (!tagPresent) nfcArmDetection();
+}
+
+// Scheduled every NFC_IRQ_CHECK_INTERVAL: pick up a tag arrival posted by the IRQ
+static void checkNfcIrq() {
+  uint8_t uid[7];
+  uint8_t uidLen = 0;
+
+  if (tagPresent) return;
+  if (!nfcDetectArmed()) {
+    nfcArmDetection(); // re-arm after another PN532 command aborted it
+    return;
+  }
+  if (!nfcTagDetected(uid, &uidLen)) return;
+
+  // The placement path starts at the IRQ edge, not at this check
+  uint32_t detectStart = nfcDetectedAtUs();
+  latencyRecord(LAT_DETECT, micros() - detectStart);
+
+  lastNfcCheck = millis();
+  handleTagPoll(true, uid, uidLen, detectStart);
+  updateNfcMode();
+}
+
+// The tag on the reader stays selected while it plays, so one READ of its
+// first block (UID and lock bytes) says it is still there, and still the
+// same tag, without a full anticollision/select. Anything that breaks the
+// selection (a glitch, another tag) falls back to a full detection, and so
+// does every check on a tag that has never answered the READ.
+static bool tagStillThere() {
+  if (pageRead == PAGE_READ_REFUSED) return false;
+
+  uint8_t block[16];
+  uint32_t start = micros();
+  bool read = nfc.readPages(0, block);
+  latencyRecord(LAT_PRESENCE, micros() - start);
+  if (!read) {
+    // Once it has worked, a failed READ is a glitch worth trying again
+    if (pageRead == PAGE_READ_UNKNOWN) pageRead = PAGE_READ_REFUSED;
+    return false;
+  }
+  pageRead = PAGE_READ_WORKS;
+
+  // NTAG page 0 = UID0-2 + BCC0, page 1 = UID3-6
+  if (currentUIDLength == 7) return memcmp(block, currentUID, 3) == 0 && memcmp(block + 4, currentUID + 3, 4) == 0;
+  return memcmp(block, currentUID, currentUIDLength) == 0;
+}
+
+// Scheduled at the adaptive cadence (nfc_poll.h): look for a tag, report arrivals and removals
+static void pollNfc() {
+  static bool announced = false;
+  uint8_t uid[7];
+  uint8_t uidLen = 0;
+
+  lastNfcCheck = millis();
+
+  // Once per wait, not on every (fast) poll
+  if (!tagPresent && !announced) LOG_I("Waiting for a tag... (tap now)");
+  announced = !tagPresent;
+
+  nfcDisarm();
+  uint32_t detectStart = micros();
+  bool success = false;
+  if (tagPresent && !missing && tagStillThere()) {
+    success = true;
+    uidLen = currentUIDLength;
+    memcpy(uid, currentUID, uidLen);
+  } else {
+    success = nfc.readPassiveTargetID(uid, &uidLen, 50);
+    if (success) latencyRecord(LAT_DETECT, micros() - detectStart);
+  }
+
+  handleTagPoll(success, uid, uidLen, detectStart);
+  updateNfcMode();
+
+  nfcScheduler.setInterval(nfcPollTask, nfcPollNextInterval(tagPresent));
+
+  // Sleep the reader until the next poll, unless it is waiting for a tag on
+  // the IRQ line, or a tag is on it: PowerDown drops the RF field, and with
+  // it the tag's selection the presence checks rely on
+  if (NFC_POWER_DOWN && !nfcDetectArmed() && !tagPresent) {
+    nfc.powerDown();
+  }
+}
+
+// Act on the outcome of one tag read
+static void handleTagPoll(bool success, const uint8_t *uid, uint8_t uidLen, uint32_t detectStartUs) {
+  // If tag detected, build new string for comparison with global
+  if (success) {
+
+    // update last seen time
+    lastTagSeen = millis();
+    readerLastHeard = lastTagSeen;
+    missing = false; // a missed read, not a removal
+
+    // If new tag detected
+
+    bool newTag = !tagPresent || (uidLen != currentUIDLength) || (memcmp(uid, currentUID, uidLen) != 0);
+
+    if (newTag) {
+      tagPresent = true;
+      memcpy(currentUID, uid, uidLen);
+      currentUIDLength = uidLen;
+      hasPlayedForCurrentTag = false;  // allow playback for this tag
+      unreadableSent = false;
+      pageRead = PAGE_READ_UNKNOWN;
+
+      logUid();
+      bootTagRead();
+    }
+
+    // Triggers playback only once per tag reading. Known records play
+    // straight from the cache and get their NDEF checked afterwards.
+    if (!hasPlayedForCurrentTag) {
+      TagCommand cmd;
+      if (tagCache.lookup(currentUID, currentUIDLength, cmd)) {
+        LOG_I("Known record, playing from cache");
+        sentCmd = cmd;
+        sendTag(TAG_PLACED, cmd, detectStartUs, true);
+        hasPlayedForCurrentTag = true;
+        nfcScheduler.startJob(verifyCachedTagJob);
+      } else if (!readTagCommand(cmd)) {
+        LOG_W("No NDEF text found (or read failed). Ensure tag is NDEF formatted and contains a Text record.");
+        if (!unreadableSent) sendTag(TAG_UNREADABLE, cmd, detectStartUs);
+        unreadableSent = true;
+      } else if (!cmd.valid) {
+        LOG_W("Failed to parse tag payload.");
+        if (!unreadableSent) sendTag(TAG_UNREADABLE, cmd, detectStartUs);
+        unreadableSent = true;
+      } else {
+        tagCache.store(currentUID, currentUIDLength, cmd);
+        sentCmd = cmd;
+        sendTag(TAG_PLACED, cmd, detectStartUs);
+        hasPlayedForCurrentTag = true;
+      }
+    }
+
+  } else {
+
+    // The removal path starts at the first poll that misses the tag
+    if (tagPresent && !missing) {
+      missing = true;
+      missStartUs = detectStartUs;
+    }
+
+    // No tag read this iteration: it's gone once unseen for the debounce time
+    if (tagPresent && millis() - lastTagSeen >= TAG_REMOVAL_DEBOUNCE) {
+      tagPresent = false;
+      hasPlayedForCurrentTag = false;  // reset so next tag triggers playback
+      missing = false;
+      LOG_I("Tag removed - stopping playback");
+      sendTag(TAG_REMOVED, sentCmd, missStartUs);
+
+      // The next record is likely to follow soon: poll fast for a while
+      nfcPollBurst();
+
+      // Clear UID state
+      currentUIDLength = 0;
+      memset(currentUID, 0, sizeof(currentUID));
+    }
+  }
+}
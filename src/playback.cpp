@@ -0,0 +1,233 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "app_tasks.h"
+#include "config.h"
+#include "log.h"
+#include "peripherals.h"
+#include "playback.h"
+#include "spsc_queue.h"
+
+struct BusyEdge {
+  bool low;
+  uint32_t atMs;
+};
+
+// Producer: the BUSY interrupt, or playbackResync() with interrupts held off
+static SpscQueue<BusyEdge, 8> edges;
+static volatile bool queuedLow = false; // the level the last queued edge left BUSY at
+static portMUX_TYPE producerLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Play commands on their way to the module. The driver answers commands in
+// the order they were sent, so the ACKs pop these in order too.
+struct PendingPlay {
+  DFResponseFn onStarted;
+  uint32_t seq;
+};
+static const uint8_t PENDING_SIZE = DFPlayer::TX_QUEUE_SIZE + 1;
+static PendingPlay pending[PENDING_SIZE];
+static uint8_t pendingHead = 0, pendingTail = 0;
+static uint32_t playSeq = 0;   // the newest play command sent
+static uint32_t stopSeq = 0;   // playSeq when playback was stopped: older ACKs start nothing
+
+// Consumer: the audio task
+static PlaybackState state = PLAYBACK_STOPPED;
+static PlaybackDoneFn finishedFn = nullptr; // for the track playing (or starting) now
+static bool looping = false;
+static bool acked = false;          // STARTING: the module has taken the command...
+static unsigned long ackedMs = 0;   // ...at this time
+static bool busyLow = false;        // BUSY as the replayed edges left it
+static unsigned long lastEdgeMs = 0;
+
+static uint32_t finishedByBusy = 0;
+static uint32_t finishedByFrame = 0;
+static uint32_t repeatFinishes = 0;
+static uint32_t startTimeouts = 0;
+
+static const char *const STATE_NAMES[] = {"stopped", "starting", "playing"};
+
+
+// ======== BUSY capture ========
+
+static void IRAM_ATTR queueEdge(bool low, uint32_t atMs) {
+  if (low == queuedLow) return;
+  if (edges.push({low, atMs})) queuedLow = low;
+}
+
+static void IRAM_ATTR onBusyEdge() {
+  portENTER_CRITICAL_ISR(&producerLock);
+  queueEdge(gpio_get_level((gpio_num_t)DF_BUSY_pin) == 0, millis());
+  portEXIT_CRITICAL_ISR(&producerLock);
+  appTaskNotifyFromIsr(APP_TASK_AUDIO);
+}
+
+void playbackBegin() {
+  if (DF_BUSY_pin < 0) return;
+  pinMode(DF_BUSY_pin, INPUT_PULLUP); // an unpowered module reads as not playing
+  busyLow = queuedLow = gpio_get_level((gpio_num_t)DF_BUSY_pin) == 0;
+  attachInterrupt(digitalPinToInterrupt(DF_BUSY_pin), onBusyEdge, CHANGE);
+}
+
+// Light sleep stops the edge interrupt: queue whatever BUSY did meanwhile
+void playbackResync() {
+  if (DF_BUSY_pin < 0) return;
+  portENTER_CRITICAL(&producerLock);
+  queueEdge(gpio_get_level((gpio_num_t)DF_BUSY_pin) == 0, millis());
+  portEXIT_CRITICAL(&producerLock);
+  appTaskNotify(APP_TASK_AUDIO);
+}
+
+
+// ======== State ========
+
+static void stopped() {
+  state = PLAYBACK_STOPPED;
+  finishedFn = nullptr;
+  looping = false;
+  stopSeq = playSeq;
+}
+
+// The end of a track, from BUSY rising or the finish frame, whichever is first
+static void finished(bool byBusy) {
+  if (state != PLAYBACK_PLAYING) {
+    if (!byBusy) repeatFinishes++; // the module's second frame, or one for a track already replaced
+    return;
+  }
+  if (looping) return; // the module carries on with the next track itself
+
+  if (byBusy) finishedByBusy++;
+  else finishedByFrame++;
+
+  PlaybackDoneFn fn = finishedFn;
+  stopped();
+  if (fn) fn();
+}
+
+static void onPlayAcked(uint8_t cmd, bool ok, uint16_t value) {
+  if (pendingTail == pendingHead) return; // the driver was restarted meanwhile
+  PendingPlay p = pending[pendingTail];
+  pendingTail = (pendingTail + 1) % PENDING_SIZE;
+
+  // Only the newest command says what plays; older ones were replaced on the wire
+  if (p.seq == playSeq && p.seq > stopSeq && state == PLAYBACK_STARTING) {
+    if (!ok) {
+      stopped();
+    } else if (DF_BUSY_pin < 0) {
+      state = PLAYBACK_PLAYING;
+    } else {
+      acked = true;
+      ackedMs = millis();
+    }
+  }
+  if (p.onStarted) p.onStarted(cmd, ok, value);
+}
+
+static bool sendPlay(bool sent, DFResponseFn onStarted, PlaybackDoneFn onFinished, bool loops) {
+  if (!sent) return false;
+  pending[pendingHead] = {onStarted, ++playSeq};
+  pendingHead = (pendingHead + 1) % PENDING_SIZE;
+
+  state = PLAYBACK_STARTING;
+  finishedFn = onFinished;
+  looping = loops;
+  acked = false;
+  return true;
+}
+
+static bool pendingFull() {
+  return (pendingHead + 1) % PENDING_SIZE == pendingTail;
+}
+
+
+// ======== Commands ========
+
+bool playbackPlayFolder(uint8_t folder, uint8_t track, DFResponseFn onStarted, PlaybackDoneFn onFinished) {
+  if (pendingFull()) return false;
+  return sendPlay(player.playFolder(folder, track, onPlayAcked), onStarted, onFinished, false);
+}
+
+bool playbackLoopFolder(uint8_t folder, DFResponseFn onStarted) {
+  if (pendingFull()) return false;
+  return sendPlay(player.loopFolder(folder, onPlayAcked), onStarted, nullptr, true);
+}
+
+void playbackStop() {
+  player.stop();
+  stopped();
+}
+
+void playbackReset() {
+  pendingHead = pendingTail = 0;
+  stopped();
+}
+
+
+// ======== Events ========
+
+void playbackFrame(uint8_t event, uint16_t param) {
+  switch (event) {
+    case DF_EVT_TRACK_FINISHED:
+      finished(false);
+      break;
+    case DF_EVT_CARD_REMOVED:
+      stopped();
+      break;
+    case DF_EVT_ONLINE: // the module restarted: a play queued behind the reset still stands
+      if (state == PLAYBACK_PLAYING || acked) stopped();
+      break;
+    default:
+      break;
+  }
+}
+
+void playbackService() {
+  BusyEdge e;
+  while (edges.pop(e)) {
+    busyLow = e.low;
+    lastEdgeMs = e.atMs;
+    if (!e.low) {
+      finished(true);
+    } else if (state == PLAYBACK_STOPPED || (state == PLAYBACK_STARTING && acked)) {
+      // Audio started: the track just ACKed, or one the module moved on to
+      state = PLAYBACK_PLAYING;
+    }
+  }
+
+  if (state != PLAYBACK_STARTING || !acked) return;
+  unsigned long since = millis() - ackedMs;
+  if (busyLow && since >= PLAYBACK_SETTLE_MS) {
+    state = PLAYBACK_PLAYING; // the replaced track's low level ran straight into this one
+  } else if (!busyLow && since >= PLAYBACK_START_TIMEOUT) {
+    LOG_W("⚠️ DFPlayer took the track but BUSY never went low");
+    startTimeouts++;
+    stopped();
+  }
+}
+
+
+// ======== Queries ========
+
+PlaybackState playbackState() {
+  return state;
+}
+
+bool playbackWakeOnEnd() {
+  return DF_BUSY_pin >= 0 && state == PLAYBACK_PLAYING && busyLow;
+}
+
+unsigned long playbackLastHeardMs() {
+  if (DF_BUSY_pin >= 0 && busyLow) return millis(); // audio is coming out right now
+  unsigned long rx = player.lastRxMillis();
+  return (long)(lastEdgeMs - rx) > 0 ? lastEdgeMs : rx;
+}
+
+
+// ======== Reporting ========
+
+void playbackPrintStats() {
+  Serial.printf("▶️ Playback: %s, %lu tracks ended (%lu by BUSY, %lu by frame), %lu repeat finish frames, %lu starts timed out, %lu BUSY edges dropped\n",
+                STATE_NAMES[state], (unsigned long)(finishedByBusy + finishedByFrame),
+                (unsigned long)finishedByBusy, (unsigned long)finishedByFrame, (unsigned long)repeatFinishes,
+                (unsigned long)startTimeouts, (unsigned long)edges.droppedCount());
+}
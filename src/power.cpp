@@ -0,0 +1,136 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "config.h"
+#include "power.h"
+#include "app_tasks.h"
+#include "buttons.h"
+#include "playback.h"
+
+struct SleepVeto {
+  const char *name;
+  SleepVetoFn fn;
+  uint64_t heldUs;    // idle time spent awake because of this veto
+};
+
+static const uint8_t MAX_VETOES = 6;
+static SleepVeto vetoes[MAX_VETOES];
+static uint8_t vetoCount = 0;
+
+static unsigned long statsStart = 0;
+static uint64_t idleUs = 0;
+static uint64_t sleepUs = 0;
+static uint32_t sleeps = 0;
+static uint32_t timerWakes = 0;
+static uint32_t gpioWakes = 0;
+
+
+// ======== Setup ========
+
+void powerBegin() {
+  statsStart = millis();
+  appTasksSetIdleHandler(powerIdle);
+  if (!LIGHT_SLEEP_ENABLED) return;
+
+  esp_sleep_enable_gpio_wakeup();
+  Serial.printf("Light sleep between events (≥ %lu ms)\n", LIGHT_SLEEP_MIN_MS);
+}
+
+bool powerAddVeto(const char *name, SleepVetoFn fn) {
+  if (vetoCount >= MAX_VETOES) return false;
+  vetoes[vetoCount++] = {name, fn, 0};
+  return true;
+}
+
+
+// ======== Wake pins ========
+
+// Level wake is only armed around the sleep itself: gpio_wakeup_enable()
+// turns the pin's interrupt into a level interrupt, which would storm the
+// button and PN532 IRQ handlers while a line is held low
+static void armWakePins() {
+  gpio_wakeup_enable((gpio_num_t)Button1_pin, GPIO_INTR_LOW_LEVEL);
+  gpio_wakeup_enable((gpio_num_t)Button2_pin, GPIO_INTR_LOW_LEVEL);
+  if (NFC_IRQ_pin >= 0) gpio_wakeup_enable((gpio_num_t)NFC_IRQ_pin, GPIO_INTR_LOW_LEVEL);
+  if (playbackWakeOnEnd()) gpio_wakeup_enable((gpio_num_t)DF_BUSY_pin, GPIO_INTR_HIGH_LEVEL); // track ended
+}
+
+static void disarmWakePins() {
+  gpio_wakeup_disable((gpio_num_t)Button1_pin);
+  gpio_wakeup_disable((gpio_num_t)Button2_pin);
+  gpio_set_intr_type((gpio_num_t)Button1_pin, GPIO_INTR_ANYEDGE); // back to attachInterruptArg(CHANGE)
+  gpio_set_intr_type((gpio_num_t)Button2_pin, GPIO_INTR_ANYEDGE);
+  if (NFC_IRQ_pin >= 0) {
+    gpio_wakeup_disable((gpio_num_t)NFC_IRQ_pin);
+    gpio_set_intr_type((gpio_num_t)NFC_IRQ_pin, GPIO_INTR_NEGEDGE); // back to attachInterrupt(FALLING)
+  }
+  if (DF_BUSY_pin >= 0) {
+    gpio_wakeup_disable((gpio_num_t)DF_BUSY_pin);
+    gpio_set_intr_type((gpio_num_t)DF_BUSY_pin, GPIO_INTR_ANYEDGE); // back to attachInterrupt(CHANGE)
+  }
+}
+
+
+// ======== Idle ========
+
+void powerIdle(unsigned long msToNext) {
+  int veto = -1;
+  unsigned long sleepMs = appTasksMsUntilNext(true);
+
+  if (LIGHT_SLEEP_ENABLED && sleepMs >= LIGHT_SLEEP_MIN_MS) {
+    for (uint8_t i = 0; i < vetoCount; i++) {
+      if (vetoes[i].fn()) { veto = i; break; }
+    }
+
+    if (veto < 0) {
+      armWakePins();
+      esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+      uint32_t start = micros();
+      esp_light_sleep_start();
+      sleepUs += micros() - start;
+      disarmWakePins();
+      buttonsResync();   // a press that woke the CPU has no edge interrupt behind it
+      playbackResync();  // nor does the end of a track
+      appTasksWakeAll(); // sleepable tasks run now rather than at their next tick
+
+      sleeps++;
+      esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+      if (cause == ESP_SLEEP_WAKEUP_GPIO) gpioWakes++;
+      else if (cause == ESP_SLEEP_WAKEUP_TIMER) timerWakes++;
+      return;
+    }
+  }
+
+  // Stay awake: short delay, as without a power manager
+  uint32_t start = micros();
+  delay(min(msToNext, SCHEDULER_MAX_IDLE_MS));
+  uint32_t took = micros() - start;
+  idleUs += took;
+  if (veto >= 0) vetoes[veto].heldUs += took;
+}
+
+
+// ======== Reporting ========
+
+void powerPrintStats() {
+  uint64_t totalUs = (uint64_t)(millis() - statsStart) * 1000ULL;
+  if (!totalUs) return;
+  uint64_t activeUs = totalUs > idleUs + sleepUs ? totalUs - idleUs - sleepUs : 0;
+
+  Serial.printf("🔋 Power over %lu s: active %.1f%%, idle %.1f%%, light sleep %.1f%% (%lu sleeps: %lu timer, %lu gpio wakes)\n",
+                (unsigned long)(totalUs / 1000000ULL),
+                100.0 * activeUs / totalUs, 100.0 * idleUs / totalUs, 100.0 * sleepUs / totalUs,
+                (unsigned long)sleeps, (unsigned long)timerWakes, (unsigned long)gpioWakes);
+  for (uint8_t i = 0; i < vetoCount; i++) {
+    if (!vetoes[i].heldUs) continue;
+    Serial.printf("   kept awake by %-10s %.1f s\n", vetoes[i].name, vetoes[i].heldUs / 1000000.0);
+  }
+}
+
+void powerResetStats() {
+  statsStart = millis();
+  idleUs = sleepUs = 0;
+  sleeps = timerWakes = gpioWakes = 0;
+  for (uint8_t i = 0; i < vetoCount; i++) vetoes[i].heldUs = 0;
+}
@@ -0,0 +1,56 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "log.h"
+#include "resume.h"
+
+ResumeTable resumeTable;
+
+// NVS namespace and table layout version (uid_table.h)
+static const char *RESUME_NAMESPACE = "resume";
+static const uint32_t RESUME_VERSION = 1;
+
+
+// ======== Persistence ========
+
+ResumeTable::ResumeTable() : table(RESUME_NAMESPACE, RESUME_VERSION) {}
+
+void ResumeTable::begin() {
+  uint8_t count = table.load();
+  if (count) LOG_I("Resume table: %u records loaded", count); // audio task bring-up
+}
+
+void ResumeTable::save() {
+  if (!dirty) return;
+  dirty = false;
+  writes++;
+  table.save();
+}
+
+
+// ======== Lookup & update ========
+
+uint8_t ResumeTable::lookup(const uint8_t *uid, uint8_t uidLen, uint8_t folder) {
+  int i = table.find(uid, uidLen);
+  if (i < 0 || table.at(i).folder != folder) return 0;
+  resumed++;
+  table.touch(i);
+  return table.at(i).track;
+}
+
+void ResumeTable::remember(const uint8_t *uid, uint8_t uidLen, uint8_t folder, uint8_t track) {
+  int i = table.find(uid, uidLen);
+  if (track <= 1) {
+    if (i < 0) return;
+    table.erase(i);
+    dirty = true;
+    return;
+  }
+
+  if (i >= 0 && table.at(i).folder == folder && table.at(i).track == track) return;
+  if (table.put(uid, uidLen, {folder, track}) >= 0) dirty = true;
+}
+
+void ResumeTable::printStats() {
+  Serial.printf("⏯️ Resume: %lu records resumed, %lu flash writes%s\n",
+                (unsigned long)resumed, (unsigned long)writes, dirty ? ", changes pending" : "");
+}
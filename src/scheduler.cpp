@@ -0,0 +1,154 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <limits.h>
+#include "log.h"
+#include "scheduler.h"
+
+// Deadline test that survives millis() rollover
+static bool isDue(unsigned long now, unsigned long deadline) {
+  return (long)(now - deadline) >= 0;
+}
+
+
+// ======== Periodic tasks ========
+
+int Scheduler::addTask(const char* name, TaskFn fn, unsigned long intervalMs) {
+  if (taskCount >= MAX_TASKS) {
+    LOG_W("⚠️ Scheduler full, dropping task '%s'", name);
+    return -1;
+  }
+  Task &t = tasks[taskCount];
+  t.name = name;
+  t.fn = fn;
+  t.interval = intervalMs;
+  t.nextRun = millis();
+  t.worstUs = 0;
+  t.enabled = true;
+  t.sleepable = false;
+  return taskCount++;
+}
+
+void Scheduler::setInterval(int id, unsigned long intervalMs) {
+  if (id < 0 || id >= taskCount) return;
+  tasks[id].interval = intervalMs;
+  tasks[id].nextRun = millis() + intervalMs;
+}
+
+void Scheduler::runSoon(int id) {
+  if (id < 0 || id >= taskCount) return;
+  tasks[id].nextRun = millis();
+}
+
+void Scheduler::setEnabled(int id, bool enabled) {
+  if (id < 0 || id >= taskCount) return;
+  if (enabled && !tasks[id].enabled) tasks[id].nextRun = millis();
+  tasks[id].enabled = enabled;
+}
+
+void Scheduler::setSleepable(int id, bool sleepable) {
+  if (id < 0 || id >= taskCount) return;
+  tasks[id].sleepable = sleepable;
+}
+
+
+// ======== Resumable jobs ========
+
+bool Scheduler::startJob(JobStep step) {
+  Job *slot = nullptr;
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    if (jobs[i].step == step) { slot = &jobs[i]; break; }   // restart in place
+    if (!slot && !jobs[i].step) slot = &jobs[i];
+  }
+  if (!slot) {
+    LOG_W("⚠️ Scheduler has no free job slot");
+    return false;
+  }
+  slot->step = step;
+  slot->stage = 0;
+  slot->nextRun = millis();
+  return true;
+}
+
+void Scheduler::cancelJob(JobStep step) {
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    if (jobs[i].step == step) jobs[i].step = nullptr;
+  }
+}
+
+void Scheduler::runJobSoon(JobStep step) {
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    if (jobs[i].step == step) jobs[i].nextRun = millis();
+  }
+}
+
+bool Scheduler::jobRunning(JobStep step) const {
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    if (jobs[i].step == step) return true;
+  }
+  return false;
+}
+
+
+// ======== Main tick ========
+
+void Scheduler::tick() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Task &t = tasks[i];
+    if (!t.enabled || !isDue(millis(), t.nextRun)) continue;
+
+    t.nextRun = millis() + t.interval;
+    uint32_t start = micros();
+    t.fn();
+    uint32_t took = micros() - start;
+    if (took > t.worstUs) t.worstUs = took;
+  }
+
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    Job &j = jobs[i];
+    if (!j.step || !isDue(millis(), j.nextRun)) continue;
+
+    JobStep step = j.step;
+    uint32_t wait = step(j.stage++);
+    // The step may have cancelled or restarted itself; only touch the slot if it's still ours
+    if (j.step != step) continue;
+    if (wait == JOB_DONE) {
+      j.step = nullptr;
+    } else if (j.stage == 0) {
+      // restarted from inside its own step: leave it due immediately
+    } else {
+      j.nextRun = millis() + wait;
+    }
+  }
+}
+
+unsigned long Scheduler::msUntilNext(bool skipSleepable) const {
+  unsigned long now = millis();
+  unsigned long best = ULONG_MAX;
+
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (!tasks[i].enabled || (skipSleepable && tasks[i].sleepable)) continue;
+    if (isDue(now, tasks[i].nextRun)) return 0;
+    unsigned long left = tasks[i].nextRun - now;
+    if (left < best) best = left;
+  }
+  for (uint8_t i = 0; i < MAX_JOBS; i++) {
+    if (!jobs[i].step) continue;
+    if (isDue(now, jobs[i].nextRun)) return 0;
+    unsigned long left = jobs[i].nextRun - now;
+    if (left < best) best = left;
+  }
+  return best;
+}
+
+
+// ======== Latency reporting ========
+
+void Scheduler::printStats() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Serial.printf("      %-12s worst %.1f ms\n", tasks[i].name, tasks[i].worstUs / 1000.0);
+  }
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < taskCount; i++) tasks[i].worstUs = 0;
+}
@@ -0,0 +1,130 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+#include "config.h"
+#include "scheduler.h"
+#include "status_led.h"
+
+static const uint32_t LEDC_FREQ_HZ = 5000;
+static const uint8_t LEDC_BITS = 8; // same 0..255 scale analogWrite used
+
+// One step of a pattern: jump to the colour, or ramp to it in hardware
+// (`fade`), then hold for `ms`. A final keyframe with ms = 0 holds for good;
+// otherwise the pattern loops.
+struct LedFrame {
+  uint8_t r, g, b;
+  uint16_t ms;
+  bool fade;
+};
+
+struct LedPattern {
+  const char *name;
+  const LedFrame *frames;
+  uint8_t count;
+};
+
+// ---- Patterns ----
+static const LedFrame OFF[] = {{0, 0, 0, 0, false}};
+static const LedFrame BOOTING[] = {{10, 5, 0, 0, false}};
+static const LedFrame READY[] = {{0, 5, 0, 0, false}};
+static const LedFrame PLAYING[] = {
+  {0, 0, 8, 1500, true},
+  {0, 0, 1, 1500, true},
+};
+static const LedFrame TAG_ERROR[] = {{10, 0, 0, 0, false}};
+static const LedFrame LOW_BATTERY[] = {
+  {10, 0, 0, 300, true},
+  {0, 0, 0, 300, true},
+  {0, 0, 0, 2400, false},
+};
+static const LedFrame DFPLAYER_FAULT[] = {
+  {0, 5, 5, 200, false}, {0, 0, 0, 200, false},
+  {0, 5, 5, 200, false}, {0, 0, 0, 1400, false},
+};
+static const LedFrame NFC_FAULT[] = {
+  {5, 0, 5, 200, false}, {0, 0, 0, 200, false},
+  {5, 0, 5, 200, false}, {0, 0, 0, 200, false},
+  {5, 0, 5, 200, false}, {0, 0, 0, 1400, false},
+};
+static const LedFrame BOTH_FAULT[] = {
+  {10, 0, 0, 500, false},
+  {0, 0, 0, 500, false},
+};
+
+#define PATTERN(name, frames) {name, frames, sizeof(frames) / sizeof(frames[0])}
+static const LedPattern PATTERNS[LED_PATTERN_COUNT] = {
+  PATTERN("off", OFF),
+  PATTERN("booting", BOOTING),
+  PATTERN("ready", READY),
+  PATTERN("playing", PLAYING),
+  PATTERN("tag error", TAG_ERROR),
+  PATTERN("low battery", LOW_BATTERY),
+  PATTERN("DFPlayer fault", DFPLAYER_FAULT),
+  PATTERN("NFC fault", NFC_FAULT),
+  PATTERN("DFPlayer + NFC fault", BOTH_FAULT),
+};
+#undef PATTERN
+
+static const uint8_t PINS[3] = {StatusLight_R_Pin, StatusLight_G_Pin, StatusLight_B_Pin};
+static uint8_t duty[3] = {0, 0, 0};   // what each channel shows (or is ramping to)
+static LedPatternId current = LED_OFF;
+static uint8_t frame = 0;
+
+
+// ======== Channels ========
+
+void statusLedBegin() {
+  // RC_FAST keeps running in light sleep (the default APB clock doesn't)
+  ledcSetClockSource(LEDC_USE_RC_FAST_CLK);
+  esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_ON);
+
+  for (uint8_t i = 0; i < 3; i++) {
+    ledcAttach(PINS[i], LEDC_FREQ_HZ, LEDC_BITS);
+    ledcWrite(PINS[i], 0);
+    gpio_sleep_sel_dis((gpio_num_t)PINS[i]); // keep the LEDC on the pin through light sleep
+  }
+}
+
+static void setChannel(uint8_t i, uint8_t target, uint16_t fadeMs) {
+  if (duty[i] == target) return;
+  if (fadeMs) ledcFade(PINS[i], duty[i], target, fadeMs);
+  else ledcWrite(PINS[i], target);
+  duty[i] = target;
+}
+
+void setStatusLight(uint8_t RedVal, uint8_t GreenVal, uint8_t BlueVal) {
+  setChannel(0, RedVal, 0);
+  setChannel(1, GreenVal, 0);
+  setChannel(2, BlueVal, 0);
+}
+
+
+// ======== Patterns ========
+
+bool statusLedShow(LedPatternId pattern) {
+  if (pattern >= LED_PATTERN_COUNT || pattern == current) return false;
+  current = pattern;
+  frame = 0;
+  return true;
+}
+
+// Apply one keyframe and sleep until the next; a static pattern ends here
+uint32_t statusLedJob(uint8_t stage) {
+  const LedPattern &p = PATTERNS[current];
+  if (stage == 0) frame = 0;
+
+  const LedFrame &f = p.frames[frame];
+  uint16_t fadeMs = f.fade ? f.ms : 0;
+  setChannel(0, f.r, fadeMs);
+  setChannel(1, f.g, fadeMs);
+  setChannel(2, f.b, fadeMs);
+
+  if (!f.ms) return JOB_DONE;
+  frame = (frame + 1) % p.count;
+  return f.ms;
+}
+
+const char *statusLedPatternName(LedPatternId pattern) {
+  return pattern < LED_PATTERN_COUNT ? PATTERNS[pattern].name : "?";
+}
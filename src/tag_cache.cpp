@@ -0,0 +1,62 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "tag_cache.h"
+
+TagCache tagCache;
+
+// NVS namespace and table layout version (uid_table.h)
+static const char *CACHE_NAMESPACE = "tagcache";
+static const uint32_t CACHE_VERSION = 1;
+
+bool sameTagCommand(const TagCommand &a, const TagCommand &b) {
+  return a.folder == b.folder && a.track == b.track && a.volume == b.volume &&
+         a.shuffle == b.shuffle && a.valid == b.valid;
+}
+
+
+// ======== Persistence ========
+
+TagCache::TagCache() : table(CACHE_NAMESPACE, CACHE_VERSION) {}
+
+void TagCache::begin() {
+  uint8_t count = table.load();
+  if (count) Serial.printf("Tag cache: %u records loaded\n", count);
+}
+
+
+// ======== Lookup & update ========
+
+bool TagCache::lookup(const uint8_t *uid, uint8_t uidLen, TagCommand &out) {
+  int i = table.find(uid, uidLen);
+  if (i < 0) {
+    misses++;
+    return false;
+  }
+  hits++;
+  table.touch(i); // no flash write per hit
+  out = table.at(i);
+  return true;
+}
+
+void TagCache::store(const uint8_t *uid, uint8_t uidLen, const TagCommand &cmd) {
+  if (!cmd.valid) return;
+
+  int i = table.find(uid, uidLen);
+  if (i >= 0 && sameTagCommand(table.at(i), cmd)) {
+    table.touch(i);
+    return;
+  }
+  if (table.put(uid, uidLen, cmd) >= 0) table.save();
+}
+
+void TagCache::invalidate(const uint8_t *uid, uint8_t uidLen) {
+  int i = table.find(uid, uidLen);
+  if (i < 0) return;
+  table.erase(i);
+  table.save();
+}
+
+void TagCache::printStats() {
+  Serial.printf("🏷️ Tag cache: %lu hits, %lu misses, %lu stale\n",
+                (unsigned long)hits, (unsigned long)misses, (unsigned long)stale);
+}
@@ -0,0 +1,109 @@
+// Tag payload parser. No Arduino headers and no allocation, so it also builds on a host.
+#include <ctype.h>
+#include "tag_parser.h"
+
+// ======== Option keywords ========
+// To add a keyword, write a handler and add a row to KEYWORDS. The handler gets
+// the number that followed the keyword (-1 if there was none).
+
+typedef bool (*KeywordHandler)(TagCommand &cmd, long number);
+
+static bool applyVolume(TagCommand &cmd, long number) {
+  if (number < 0 || number > 30) return false;
+  cmd.volume = (int)number;
+  return true;
+}
+
+static bool applyShuffle(TagCommand &cmd, long) {
+  cmd.shuffle = true;
+  return true;
+}
+
+struct TagKeyword {
+  const char *name;
+  KeywordHandler apply;
+};
+
+static const TagKeyword KEYWORDS[] = {
+  { "volume",  applyVolume },
+  { "shuffle", applyShuffle },
+};
+
+
+// ======== Tokenizer ========
+
+// Case-insensitive compare of [s, s+len) against a lowercase keyword
+static bool keywordEquals(const char *s, size_t len, const char *keyword) {
+  size_t i = 0;
+  for (; i < len && keyword[i]; i++) {
+    if (tolower((unsigned char)s[i]) != keyword[i]) return false;
+  }
+  return i == len && keyword[i] == '\0';
+}
+
+static void applyOption(TagCommand &cmd, const char *word, size_t wordLen, long number) {
+  for (const TagKeyword &kw : KEYWORDS) {
+    if (keywordEquals(word, wordLen, kw.name)) {
+      kw.apply(cmd, number);
+      return;
+    }
+  }
+  // Unknown keywords are ignored so older firmware tolerates newer tags
+}
+
+TagCommand parseTagPayload(const char* payload, size_t len) {
+  TagCommand cmd = {0, 1, -1, false, false};  // default track to 1
+
+  // Per-field state, reset at every '|'
+  bool firstField = true;
+  const char *word = nullptr;
+  size_t wordLen = 0;
+  long number = -1;
+  bool inNumber = false;
+
+  for (size_t i = 0; i <= len; i++) {
+    char c = (i < len) ? payload[i] : '|'; // a virtual '|' closes the last field
+
+    if (c == '|') {
+      if (firstField) {
+        // Folder field: a number, 0 is not a valid DFPlayer folder
+        if (number <= 0 || number > 99) return cmd;
+        cmd.folder = (uint16_t)number;
+        firstField = false;
+      } else if (wordLen) {
+        applyOption(cmd, word, wordLen, number);
+      }
+      word = nullptr;
+      wordLen = 0;
+      number = -1;
+      inNumber = false;
+      continue;
+    }
+
+    if (isdigit((unsigned char)c)) {
+      // First run of digits after the folder/keyword is its number
+      if (number < 0) {
+        number = 0;
+        inNumber = true;
+      }
+      if (inNumber && number < 1000) number = number * 10 + (c - '0');
+      continue;
+    }
+    inNumber = false;
+
+    if (isalpha((unsigned char)c) && !firstField) {
+      if (word && word + wordLen == payload + i) {
+        wordLen++;                     // still inside the current keyword
+      } else {
+        // A new keyword: settle the previous one ("volume 5 shuffle" in one field)
+        if (word) applyOption(cmd, word, wordLen, number);
+        word = payload + i;
+        wordLen = 1;
+        number = -1;
+      }
+    }
+  }
+
+  cmd.valid = true;
+  return cmd;
+}
@@ -0,0 +1,209 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include <atomic>
+#include "app_tasks.h"
+#include "config.h"
+#include "hal.h"
+#include "log.h"
+#include "peripherals.h"
+#include "spsc_queue.h"
+#include "telemetry.h"
+
+struct TelemetryRecord {
+  uint32_t ms;
+  TelemetryEventType type;
+  uint8_t uidLen;
+  uint8_t uid[7];
+  int16_t a;
+  int16_t b;
+};
+
+// JSON name of each event and of its two values (nullptr: not sent)
+struct TelemetryFormat {
+  const char *name;
+  const char *a;
+  const char *b;
+};
+
+static const TelemetryFormat FORMATS[TEL_TYPE_COUNT] = {
+  {"boot",    "wake",     "mv"},
+  {"play",    "folder",   "vol"},
+  {"remove",  "secs",     nullptr},
+  {"volume",  "vol",      nullptr},
+  {"battery", "mv",       "pct"},
+  {"health",  "dfplayer", "nfc"},
+};
+
+static const unsigned long LINK_POLL_MS = 250; // ms between connection polls
+
+// Filled by the audio task, emptied by the upload job in the UI task. When
+// full, new events are dropped (and counted): the producer can't evict.
+static SpscQueue<TelemetryRecord, 64> ring;
+static uint32_t oversized = 0;  // dropped because they didn't fit a message
+static std::atomic<bool> flushWanted{false};
+
+static char payload[TELEMETRY_MAX_PAYLOAD];
+static unsigned long radioOnAt = 0;
+static unsigned long lastFailMs = 0;
+static bool failedBefore = false;
+static bool radioOn = false;
+
+// Totals since boot
+static uint32_t eventsSent = 0;
+static uint32_t bytesSent = 0;
+static uint32_t messagesSent = 0;
+static uint32_t bursts = 0;
+static uint32_t failedBursts = 0;
+static uint64_t radioMs = 0;
+
+static uint32_t uploadJob(uint8_t stage);
+
+
+// ======== Ring ========
+
+static uint32_t dropped() {
+  return ring.droppedCount() + oversized;
+}
+
+void telemetryTagEvent(TelemetryEventType type, const uint8_t *uid, uint8_t uidLen, int16_t a, int16_t b) {
+  if (!TELEMETRY_ENABLED || type >= TEL_TYPE_COUNT) return;
+
+  TelemetryRecord r = {(uint32_t)millis(), type, 0, {0}, a, b};
+  if (uid) {
+    r.uidLen = min(uidLen, (uint8_t)sizeof(r.uid));
+    memcpy(r.uid, uid, r.uidLen);
+  }
+  ring.push(r);
+
+  // Nearly full: ask the UI task to upload early rather than lose events
+  if (ring.size() >= ring.capacity() * 3 / 4) flushWanted.store(true, std::memory_order_relaxed);
+}
+
+void telemetryEvent(TelemetryEventType type, int16_t a, int16_t b) {
+  telemetryTagEvent(type, nullptr, 0, a, b);
+}
+
+
+// ======== Upload ========
+
+// Append the oldest queued events to payload[] while they fit; returns how
+// many went in and the payload length in *len
+static uint8_t buildBatch(size_t *len) {
+  size_t n = snprintf(payload, sizeof(payload), "{\"up\":%lu,\"dropped\":%lu,\"events\":[",
+                      millis(), (unsigned long)dropped());
+  uint8_t count = 0;
+  TelemetryRecord r;
+
+  for (; ring.peek(count, r); count++) {
+    const TelemetryFormat &f = FORMATS[r.type];
+    char ev[96];
+    size_t e = snprintf(ev, sizeof(ev), "%s{\"t\":%lu,\"e\":\"%s\"", count ? "," : "", (unsigned long)r.ms, f.name);
+    if (r.uidLen) {
+      e += snprintf(ev + e, sizeof(ev) - e, ",\"uid\":\"");
+      for (uint8_t i = 0; i < r.uidLen; i++) e += snprintf(ev + e, sizeof(ev) - e, "%02X", r.uid[i]);
+      e += snprintf(ev + e, sizeof(ev) - e, "\"");
+    }
+    if (f.a) e += snprintf(ev + e, sizeof(ev) - e, ",\"%s\":%d", f.a, r.a);
+    if (f.b) e += snprintf(ev + e, sizeof(ev) - e, ",\"%s\":%d", f.b, r.b);
+    e += snprintf(ev + e, sizeof(ev) - e, "}");
+
+    if (n + e + 2 >= sizeof(payload)) break; // room for the closing "]}"
+    memcpy(payload + n, ev, e);
+    n += e;
+  }
+
+  n += snprintf(payload + n, sizeof(payload) - n, "]}");
+  *len = n;
+  return count;
+}
+
+static void radioOff() {
+  telemetryLink.disconnect();
+  radioMs += millis() - radioOnAt;
+  radioOn = false;
+}
+
+static uint32_t failBurst(const char *why) {
+  radioOff();
+  failedBursts++;
+  failedBefore = true;
+  lastFailMs = millis();
+  LOG_W("📡 Telemetry upload failed (%s), %u events kept", why, (unsigned)ring.size());
+  return JOB_DONE;
+}
+
+// Stage 0 switches the radio on; later stages poll the connection, then
+// send one batch per stage so the loop runs in between
+static uint32_t uploadJob(uint8_t stage) {
+  if (stage == 0) {
+    if (!ring.size()) return JOB_DONE;
+    bursts++;
+    radioOnAt = millis();
+    radioOn = true;
+    telemetryLink.connect();
+    return LINK_POLL_MS;
+  }
+
+  switch (telemetryLink.poll()) {
+    case LINK_UP:
+      break;
+    case LINK_CONNECTING:
+      if (millis() - radioOnAt > TELEMETRY_CONNECT_TIMEOUT) return failBurst("timeout");
+      return LINK_POLL_MS;
+    default:
+      return failBurst("no connection");
+  }
+
+  size_t len = 0;
+  uint8_t count = buildBatch(&len);
+  if (!count) {
+    // An event too big for the payload buffer: drop it rather than stall the ring
+    ring.discard(1);
+    oversized++;
+    return 0;
+  }
+  if (!telemetryLink.publish(TELEMETRY_TOPIC, payload, len)) return failBurst("publish");
+
+  ring.discard(count);
+  eventsSent += count;
+  messagesSent++;
+  bytesSent += len + strlen(TELEMETRY_TOPIC);
+  if (ring.size()) return 0;
+
+  radioOff();
+  failedBefore = false;
+  return JOB_DONE;
+}
+
+void telemetryFlush() {
+  if (!TELEMETRY_ENABLED || !ring.size() || uiScheduler.jobRunning(uploadJob)) return;
+  uiScheduler.startJob(uploadJob);
+}
+
+// Early upload asked for by a nearly full ring, unless the last attempt
+// failed recently (no network in range)
+void telemetryService() {
+  if (!flushWanted.exchange(false, std::memory_order_relaxed)) return;
+  bool backingOff = failedBefore && millis() - lastFailMs < TELEMETRY_INTERVAL;
+  if (!backingOff) telemetryFlush();
+}
+
+bool telemetryActive() {
+  return radioOn;
+}
+
+
+// ======== Reporting ========
+
+void telemetryPrintStats() {
+  if (!TELEMETRY_ENABLED) return;
+
+  uint64_t onMs = radioMs + (radioOn ? millis() - radioOnAt : 0);
+  float hours = millis() / 3600000.0f;
+  Serial.printf("📡 Telemetry: %lu events in %lu messages, %lu bursts (%lu failed), %.1f kB, radio on %.1f s; %u queued, %lu dropped\n",
+                (unsigned long)eventsSent, (unsigned long)messagesSent, (unsigned long)bursts,
+                (unsigned long)failedBursts, bytesSent / 1024.0f, onMs / 1000.0f, ring.size(), (unsigned long)dropped());
+  if (hours > 0) {
+    Serial.printf("   per hour: %.1f kB, radio on %.1f s\n", bytesSent / 1024.0f / hours, onMs / 1000.0f / hours);
+  }
+}
@@ -0,0 +1,92 @@
+// ======== Library initialization ========
+#include <Arduino.h>
+#include "app_state.h"
+#include "app_tasks.h"
+#include "buttons.h"
+#include "config.h"
+#include "console.h"
+#include "health.h"
+#include "helpers.h"
+#include "log.h"
+#include "playback.h"
+#include "power.h"
+#include "status_led.h"
+#include "folder_play.h"
+#include "resume.h"
+#include "tag_cache.h"
+#include "telemetry.h"
+
+// UI task: buttons in (as events for the audio task), status light out (from
+// the published box state), plus the console, stats and telemetry uploads.
+
+static void serviceButtons();
+static void updateStatusLight();
+static void printLoopStats();
+
+static int buttonTask = -1;
+
+
+void uiTaskBegin() {
+  buttonTask = uiScheduler.addTask("buttons", serviceButtons, BUTTON_SCAN_INTERVAL);
+  uiScheduler.setEnabled(buttonTask, false); // edges wake the task; this only times held buttons
+  int lightTask = uiScheduler.addTask("status light", updateStatusLight, STATUS_LIGHT_INTERVAL);
+  int statsTask = uiScheduler.addTask("stats", printLoopStats, LOOP_STATS_INTERVAL);
+  uiScheduler.setInterval(statsTask, LOOP_STATS_INTERVAL); // first report after a full interval, not zeroes at boot
+  int consoleTask = uiScheduler.addTask("console", pollConsole, CONSOLE_POLL_INTERVAL);
+  uiScheduler.addTask("telemetry", telemetryFlush, TELEMETRY_INTERVAL);
+  int teleCheckTask = uiScheduler.addTask("tele check", telemetryService, TELEMETRY_CHECK_INTERVAL);
+
+  // Fast-cadence tasks that a wake source covers don't keep the CPU up
+  uiScheduler.setSleepable(buttonTask, true);     // button GPIOs wake (and a held one vetoes sleep)
+  uiScheduler.setSleepable(lightTask, true);      // state only changes while awake
+  uiScheduler.setSleepable(consoleTask, true);
+  uiScheduler.setSleepable(teleCheckTask, true);
+}
+
+
+// ---- Buttons: replay the edges their interrupt queued (buttons.h) ----
+void uiTaskDrain() {
+  serviceButtons();
+}
+
+static void serviceButtons() {
+  buttonsService();
+  uiScheduler.setEnabled(buttonTask, buttonsHeld()); // long press and repeat need the clock
+}
+
+
+// ---- Status light: a pattern per box state (status_led.h), restarted only when it changes ----
+static void updateStatusLight() {
+  BoxState s = readBoxState();
+  LedPatternId pattern;
+
+  if (s.booting) pattern = LED_BOOTING;
+  else if (!s.dfplayerOK && !s.nfcOK) pattern = LED_BOTH_FAULT;
+  else if (!s.dfplayerOK) pattern = LED_DFPLAYER_FAULT;
+  else if (!s.nfcOK) pattern = LED_NFC_FAULT;
+  else if (s.tagError) pattern = LED_TAG_ERROR;
+  else if (s.batteryLow) pattern = LED_LOW_BATTERY;
+  else if (s.playing) pattern = LED_PLAYING;
+  else pattern = LED_READY;
+
+  if (!statusLedShow(pattern)) return;
+  LOG_I("💡 Status light: %s", statusLedPatternName(pattern)); // names are literals
+  uiScheduler.startJob(statusLedJob);
+}
+
+
+// Report and reset the per-task CPU share and worst-case latency
+static void printLoopStats() {
+  appTasksPrintStats();
+  appTasksResetStats();
+  buttonsPrintStats();
+  tagCache.printStats();
+  folderPlayPrintStats();
+  playbackPrintStats();
+  dfplayerHealth.printStats();
+  readerHealth.printStats();
+  resumeTable.printStats();
+  powerPrintStats();
+  telemetryPrintStats();
+  logPrintStats();
+}
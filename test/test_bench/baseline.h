@@ -0,0 +1,30 @@
+// baseline.h - recorded results of the host benchmarks (test_main.cpp)
+//
+// A bench fails when it allocates more per operation than recorded, or when
+// its mean or its worst case (the slowest corpus input) runs slower than
+// BENCH_TIME_TOLERANCE times the recorded time (loose, since the numbers
+// come from whatever machine runs the tests). After a deliberate
+// change, re-record: every run prints its results as rows for this table.
+//
+// Recorded with `pio test -e native -f test_bench -v` on an x86-64 Linux host
+// (the native env builds with -O2).
+
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+struct BenchBaseline {
+  const char *name;
+  double nsPerOp;
+  double worstNsPerOp;
+  double allocsPerOp;
+};
+
+static const double BENCH_TIME_TOLERANCE = 2.0;
+
+static const BenchBaseline BASELINE[] = {
+  {"parseTagPayload", 70.0, 180.0, 0.00},
+  {"NdefDecoder", 500.0, 1800.0, 0.00},
+  {"button traces", 10.0, 13.0, 0.00},
+};
+
+#endif // BENCH_BASELINE_H
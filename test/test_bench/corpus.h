@@ -0,0 +1,245 @@
+// corpus.h - inputs for the host benchmarks (test_main.cpp)
+//
+//   PAYLOADS      tag payloads as people write them on their records: bare
+//                 folders, the documented options, mixed case and spacing,
+//                 and a few broken ones
+//   NTAG_DUMPS    NTAG user memory from page 4, as read off tags written by
+//                 phone apps, padded to whole 4-page reads
+//   BUTTON_TRACES edge timings of one button: taps, contact bounce, holds
+
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ======== Tag payloads ========
+
+static const char *const PAYLOADS[] = {
+  "07",
+  "1",
+  "12 | volume 5",
+  "03|volume 20|shuffle",
+  "42 | shuffle",
+  "09 | Volume 18 | Shuffle",
+  "15|VOLUME 25",
+  "  21  |  volume   3  ",
+  "88 | volume 12 | shuffle | lights",
+  "05 | volume 40",
+  "00 | volume 5",
+  "",
+  "|volume 5",
+  "Kids songs",
+};
+
+
+// ======== NTAG user memory ========
+
+// text
+static const uint8_t NTAG_DUMP_0[] = {
+  0x03, 0x14, 0xD1, 0x01, // page 4
+  0x10, 0x54, 0x02, 0x65, // page 5
+  0x6E, 0x30, 0x37, 0x20, // page 6
+  0x7C, 0x20, 0x76, 0x6F, // page 7
+  0x6C, 0x75, 0x6D, 0x65, // page 8
+  0x20, 0x35, 0xFE, 0x00, // page 9
+  0x00, 0x00, 0x00, 0x00, // page 10
+  0x00, 0x00, 0x00, 0x00, // page 11
+};
+// lock TLV + text
+static const uint8_t NTAG_DUMP_1[] = {
+  0x01, 0x03, 0xA0, 0x10, // page 4
+  0x44, 0x03, 0x1B, 0xD1, // page 5
+  0x01, 0x17, 0x54, 0x02, // page 6
+  0x65, 0x6E, 0x31, 0x32, // page 7
+  0x7C, 0x76, 0x6F, 0x6C, // page 8
+  0x75, 0x6D, 0x65, 0x20, // page 9
+  0x32, 0x30, 0x7C, 0x73, // page 10
+  0x68, 0x75, 0x66, 0x66, // page 11
+  0x6C, 0x65, 0xFE, 0x00, // page 12
+  0x00, 0x00, 0x00, 0x00, // page 13
+  0x00, 0x00, 0x00, 0x00, // page 14
+  0x00, 0x00, 0x00, 0x00, // page 15
+};
+// AAR then text
+static const uint8_t NTAG_DUMP_2[] = {
+  0x03, 0x34, 0x94, 0x0F, // page 4
+  0x0F, 0x61, 0x6E, 0x64, // page 5
+  0x72, 0x6F, 0x69, 0x64, // page 6
+  0x2E, 0x63, 0x6F, 0x6D, // page 7
+  0x3A, 0x70, 0x6B, 0x67, // page 8
+  0x63, 0x6F, 0x6D, 0x2E, // page 9
+  0x65, 0x78, 0x61, 0x6D, // page 10
+  0x70, 0x6C, 0x65, 0x2E, // page 11
+  0x62, 0x6F, 0x78, 0x51, // page 12
+  0x01, 0x0F, 0x54, 0x02, // page 13
+  0x65, 0x6E, 0x30, 0x33, // page 14
+  0x20, 0x7C, 0x20, 0x73, // page 15
+  0x68, 0x75, 0x66, 0x66, // page 16
+  0x6C, 0x65, 0xFE, 0x00, // page 17
+  0x00, 0x00, 0x00, 0x00, // page 18
+  0x00, 0x00, 0x00, 0x00, // page 19
+};
+// UTF-16 text
+static const uint8_t NTAG_DUMP_3[] = {
+  0x03, 0x1F, 0xD1, 0x01, // page 4
+  0x1B, 0x54, 0x82, 0x65, // page 5
+  0x6E, 0x00, 0x30, 0x00, // page 6
+  0x35, 0x00, 0x20, 0x00, // page 7
+  0x7C, 0x00, 0x20, 0x00, // page 8
+  0x73, 0x00, 0x68, 0x00, // page 9
+  0x75, 0x00, 0x66, 0x00, // page 10
+  0x66, 0x00, 0x6C, 0x00, // page 11
+  0x65, 0xFE, 0x00, 0x00, // page 12
+  0x00, 0x00, 0x00, 0x00, // page 13
+  0x00, 0x00, 0x00, 0x00, // page 14
+  0x00, 0x00, 0x00, 0x00, // page 15
+};
+// long text, 3-byte TLV
+static const uint8_t NTAG_DUMP_4[] = {
+  0x03, 0xFF, 0x01, 0x3A, // page 4
+  0xC1, 0x01, 0x00, 0x00, // page 5
+  0x01, 0x33, 0x54, 0x02, // page 6
+  0x65, 0x6E, 0x30, 0x39, // page 7
+  0x20, 0x7C, 0x20, 0x76, // page 8
+  0x6F, 0x6C, 0x75, 0x6D, // page 9
+  0x65, 0x20, 0x31, 0x32, // page 10
+  0x20, 0x7C, 0x20, 0x42, // page 11
+  0x65, 0x64, 0x74, 0x69, // page 12
+  0x6D, 0x65, 0x20, 0x73, // page 13
+  0x74, 0x6F, 0x72, 0x69, // page 14
+  0x65, 0x73, 0x2C, 0x20, // page 15
+  0x73, 0x69, 0x64, 0x65, // page 16
+  0x20, 0x41, 0x20, 0x61, // page 17
+  0x6E, 0x64, 0x20, 0x73, // page 18
+  0x69, 0x64, 0x65, 0x20, // page 19
+  0x42, 0x2E, 0x20, 0x42, // page 20
+  0x65, 0x64, 0x74, 0x69, // page 21
+  0x6D, 0x65, 0x20, 0x73, // page 22
+  0x74, 0x6F, 0x72, 0x69, // page 23
+  0x65, 0x73, 0x2C, 0x20, // page 24
+  0x73, 0x69, 0x64, 0x65, // page 25
+  0x20, 0x41, 0x20, 0x61, // page 26
+  0x6E, 0x64, 0x20, 0x73, // page 27
+  0x69, 0x64, 0x65, 0x20, // page 28
+  0x42, 0x2E, 0x20, 0x42, // page 29
+  0x65, 0x64, 0x74, 0x69, // page 30
+  0x6D, 0x65, 0x20, 0x73, // page 31
+  0x74, 0x6F, 0x72, 0x69, // page 32
+  0x65, 0x73, 0x2C, 0x20, // page 33
+  0x73, 0x69, 0x64, 0x65, // page 34
+  0x20, 0x41, 0x20, 0x61, // page 35
+  0x6E, 0x64, 0x20, 0x73, // page 36
+  0x69, 0x64, 0x65, 0x20, // page 37
+  0x42, 0x2E, 0x20, 0x42, // page 38
+  0x65, 0x64, 0x74, 0x69, // page 39
+  0x6D, 0x65, 0x20, 0x73, // page 40
+  0x74, 0x6F, 0x72, 0x69, // page 41
+  0x65, 0x73, 0x2C, 0x20, // page 42
+  0x73, 0x69, 0x64, 0x65, // page 43
+  0x20, 0x41, 0x20, 0x61, // page 44
+  0x6E, 0x64, 0x20, 0x73, // page 45
+  0x69, 0x64, 0x65, 0x20, // page 46
+  0x42, 0x2E, 0x20, 0x42, // page 47
+  0x65, 0x64, 0x74, 0x69, // page 48
+  0x6D, 0x65, 0x20, 0x73, // page 49
+  0x74, 0x6F, 0x72, 0x69, // page 50
+  0x65, 0x73, 0x2C, 0x20, // page 51
+  0x73, 0x69, 0x64, 0x65, // page 52
+  0x20, 0x41, 0x20, 0x61, // page 53
+  0x6E, 0x64, 0x20, 0x73, // page 54
+  0x69, 0x64, 0x65, 0x20, // page 55
+  0x42, 0x2E, 0x20, 0x42, // page 56
+  0x65, 0x64, 0x74, 0x69, // page 57
+  0x6D, 0x65, 0x20, 0x73, // page 58
+  0x74, 0x6F, 0x72, 0x69, // page 59
+  0x65, 0x73, 0x2C, 0x20, // page 60
+  0x73, 0x69, 0x64, 0x65, // page 61
+  0x20, 0x41, 0x20, 0x61, // page 62
+  0x6E, 0x64, 0x20, 0x73, // page 63
+  0x69, 0x64, 0x65, 0x20, // page 64
+  0x42, 0x2E, 0x20, 0x42, // page 65
+  0x65, 0x64, 0x74, 0x69, // page 66
+  0x6D, 0x65, 0x20, 0x73, // page 67
+  0x74, 0x6F, 0x72, 0x69, // page 68
+  0x65, 0x73, 0x2C, 0x20, // page 69
+  0x73, 0x69, 0x64, 0x65, // page 70
+  0x20, 0x41, 0x20, 0x61, // page 71
+  0x6E, 0x64, 0x20, 0x73, // page 72
+  0x69, 0x64, 0x65, 0x20, // page 73
+  0x42, 0x2E, 0x20, 0x42, // page 74
+  0x65, 0x64, 0x74, 0x69, // page 75
+  0x6D, 0x65, 0x20, 0x73, // page 76
+  0x74, 0x6F, 0x72, 0x69, // page 77
+  0x65, 0x73, 0x2C, 0x20, // page 78
+  0x73, 0x69, 0x64, 0x65, // page 79
+  0x20, 0x41, 0x20, 0x61, // page 80
+  0x6E, 0x64, 0x20, 0x73, // page 81
+  0x69, 0x64, 0x65, 0x20, // page 82
+  0x42, 0x2E, 0xFE, 0x00, // page 83
+};
+// blank (empty message)
+static const uint8_t NTAG_DUMP_5[] = {
+  0x03, 0x00, 0xFE, 0x00, // page 4
+  0x00, 0x00, 0x00, 0x00, // page 5
+  0x00, 0x00, 0x00, 0x00, // page 6
+  0x00, 0x00, 0x00, 0x00, // page 7
+};
+
+struct NtagDump {
+  const char *name;
+  const uint8_t *memory;
+  size_t len;
+  const char *text; // the record's text; nullptr if there is none
+};
+
+#define DUMP(name, memory, text) { name, memory, sizeof(memory), text }
+static const NtagDump NTAG_DUMPS[] = {
+  DUMP("text", NTAG_DUMP_0, "07 | volume 5"),
+  DUMP("lock TLV + text", NTAG_DUMP_1, "12|volume 20|shuffle"),
+  DUMP("AAR then text", NTAG_DUMP_2, "03 | shuffle"),
+  DUMP("UTF-16 text", NTAG_DUMP_3, "05 | shuffle"),
+  DUMP("long text, 3-byte TLV", NTAG_DUMP_4,
+       "09 | volume 12 | Bedtime stories, side A and side B. Bedtime stories, side A and side B. "
+       "Bedtime stories, side A and side B. Bedtime stories, side A and side B. "
+       "Bedtime stories, side A and side B. Bedtime stories, side A and side B. "
+       "Bedtime stories, side A and side B. Bedtime stories, side A and side B."),
+  DUMP("blank (empty message)", NTAG_DUMP_5, nullptr),
+};
+#undef DUMP
+
+
+// ======== Button traces ========
+
+struct ButtonTraceEdge {
+  uint32_t atMs;
+  bool pressed;
+};
+
+struct ButtonTrace {
+  const char *name;
+  const ButtonTraceEdge *edges;
+  size_t count;
+  uint8_t shorts, longs, repeats; // the gestures it makes
+};
+
+static const ButtonTraceEdge TAP[] = {{0, true}, {180, false}};
+static const ButtonTraceEdge DOUBLE_TAP[] = {{0, true}, {150, false}, {400, true}, {560, false}};
+static const ButtonTraceEdge BOUNCY_TAP[] = {{0, true}, {4, false}, {9, true}, {15, false}, {20, true}, {160, false}};
+static const ButtonTraceEdge GLITCH[] = {{0, true}, {40, false}};
+static const ButtonTraceEdge HOLD[] = {{0, true}, {1300, false}};
+static const ButtonTraceEdge HOLD_REPEATING[] = {{0, true}, {3900, false}};
+
+#define TRACE(name, edges, shorts, longs, repeats) \
+  { name, edges, sizeof(edges) / sizeof(edges[0]), shorts, longs, repeats }
+static const ButtonTrace BUTTON_TRACES[] = {
+  TRACE("tap", TAP, 1, 0, 0),
+  TRACE("double tap", DOUBLE_TAP, 2, 0, 0),
+  TRACE("bouncy tap", BOUNCY_TAP, 1, 0, 0),
+  TRACE("glitch", GLITCH, 0, 0, 0),
+  TRACE("hold", HOLD, 0, 1, 0),
+  TRACE("hold, repeating", HOLD_REPEATING, 0, 1, 3),
+};
+#undef TRACE
+
+#endif // BENCH_CORPUS_H
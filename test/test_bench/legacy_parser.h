@@ -0,0 +1,161 @@
+// legacy_parser.h - the String-based parseTagPayload() that tag_parser.cpp
+// replaced, kept only as the benchmark's point of comparison
+//
+// `legacy::String` has just the members that parser used, with the heap
+// behaviour of the ESP32 core's WString: up to 14 characters live inline
+// (SSO), anything longer gets a heap buffer sized to fit, and a String that
+// outgrows its buffer reallocates. Its buffers come from operator new, so
+// the bench's allocation counter sees them.
+//
+// The parser is as it was, minus its Serial.printf() calls: only the parsing
+// is compared.
+
+#ifndef LEGACY_PARSER_H
+#define LEGACY_PARSER_H
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tag_parser.h"
+
+namespace legacy {
+
+class String {
+public:
+  String(const char *s = "") { assign(s, strlen(s)); }
+  String(const String &s) { assign(s.c_str(), s.len); }
+  ~String() { if (heap) delete[] heap; }
+
+  String &operator=(const String &s) {
+    if (this != &s) assign(s.c_str(), s.len);
+    return *this;
+  }
+  String &operator=(const char *s) {
+    assign(s, strlen(s));
+    return *this;
+  }
+
+  unsigned int length() const { return len; }
+  const char *c_str() const { return heap ? heap : sso; }
+  char operator[](unsigned int i) const { return i < len ? c_str()[i] : 0; }
+
+  int indexOf(char c) const {
+    const char *p = strchr(c_str(), c);
+    return p ? (int)(p - c_str()) : -1;
+  }
+  int indexOf(const char *s) const {
+    const char *p = strstr(c_str(), s);
+    return p ? (int)(p - c_str()) : -1;
+  }
+
+  String substring(unsigned int from) const { return substring(from, len); }
+  String substring(unsigned int from, unsigned int to) const {
+    String out;
+    if (from > len) from = len;
+    if (to > len) to = len;
+    if (from < to) out.assign(c_str() + from, to - from);
+    return out;
+  }
+
+  void trim() {
+    const char *s = c_str();
+    unsigned int b = 0, e = len;
+    while (b < e && isspace((unsigned char)s[b])) b++;
+    while (e > b && isspace((unsigned char)s[e - 1])) e--;
+    memmove(buf(), s + b, e - b);
+    len = e - b;
+    buf()[len] = '\0';
+  }
+  void toLowerCase() {
+    for (char *p = buf(); *p; p++) *p = (char)tolower((unsigned char)*p);
+  }
+  long toInt() const { return atol(c_str()); }
+
+private:
+  static const unsigned int SSO_CAPACITY = 14;
+
+  char *buf() { return heap ? heap : sso; }
+
+  void assign(const char *s, unsigned int n) {
+    if (n > SSO_CAPACITY && n > capacity) {
+      char *grown = new char[n + 1];
+      if (heap) delete[] heap;
+      heap = grown;
+      capacity = n;
+    }
+    memmove(buf(), s, n);
+    len = n;
+    buf()[n] = '\0';
+  }
+
+  char sso[SSO_CAPACITY + 1] = {};
+  char *heap = nullptr;
+  unsigned int capacity = 0;
+  unsigned int len = 0;
+};
+
+inline TagCommand parseTagPayload(const String& payload) {
+  TagCommand cmd = {0, 1, -1, false, false};  // default track to 1
+
+  if (payload.length() == 0) {
+    return cmd;
+  }
+
+  // Find the pipe delimiter to split folder from options
+  int pipeIndex = payload.indexOf('|');
+  String folderStr;
+  String optionsStr;
+
+  if (pipeIndex > 0) {
+    folderStr = payload.substring(0, pipeIndex);
+    optionsStr = payload.substring(pipeIndex + 1);
+  } else {
+    folderStr = payload;
+    optionsStr = "";
+  }
+
+  // Parse folder (e.g., "07")
+  folderStr.trim();
+  cmd.folder = folderStr.toInt();
+
+  if (cmd.folder == 0) {
+    // Invalid folder (0 is not valid in DFPlayer)
+    return cmd;
+  }
+
+  // Parse options (e.g., "volume 5 | shuffle")
+  optionsStr.toLowerCase(); // case-insensitive
+
+  // Look for "volume" keyword
+  int volIndex = optionsStr.indexOf("volume");
+  if (volIndex >= 0) {
+    // Extract the number after "volume"
+    unsigned int numStart = volIndex + 6; // length of "volume"
+    while (numStart < optionsStr.length() && !isdigit(optionsStr[numStart])) {
+      numStart++;
+    }
+    if (numStart < optionsStr.length()) {
+      unsigned int numEnd = numStart;
+      while (numEnd < optionsStr.length() && isdigit(optionsStr[numEnd])) {
+        numEnd++;
+      }
+      String volStr = optionsStr.substring(numStart, numEnd);
+      int vol = volStr.toInt();
+      if (vol >= 0 && vol <= 30) {
+        cmd.volume = vol;
+      }
+    }
+  }
+
+  // Check for "shuffle" keyword
+  if (optionsStr.indexOf("shuffle") >= 0) {
+    cmd.shuffle = true;
+  }
+
+  cmd.valid = true;
+  return cmd;
+}
+
+} // namespace legacy
+
+#endif // LEGACY_PARSER_H
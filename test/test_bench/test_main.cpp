@@ -0,0 +1,273 @@
+// Host micro-benchmarks for the tag and button paths
+//
+//   pio test -e native -f test_bench -v
+//
+// Each bench times every input of its corpus (corpus.h) on its own, many
+// times over, keeping each input's best round. It reports the mean ns per
+// operation over the corpus, the worst case (the slowest input), and heap
+// allocations per operation. Allocations are counted by replacing the global
+// operator new; time is std::chrono, not the sim's virtual clock. A bench
+// with a row in baseline.h fails when it regresses against it.
+//
+//   parseTagPayload   the in-place parser against the String-based one it
+//                     replaced (legacy_parser.h), including the String the old
+//                     code built from the tag's text
+//   NdefDecoder       one NTAG dump decoded, fed 4 pages at a time as
+//                     readNdefTextFromTag() reads them
+//   button traces     one edge replayed through the button state machine,
+//                     held gestures first, as buttonsService() does
+
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <string.h>
+#include <vector>
+#include "baseline.h"
+#include "buttons.h"
+#include "corpus.h"
+#include "legacy_parser.h"
+#include "ndef.h"
+#include "tag_parser.h"
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+
+
+// ======== Allocation counter ========
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+
+// ======== Harness ========
+
+static const int ROUNDS = 15;
+static const int REPEATS = 500; // runs of each input per round
+
+struct BenchResult {
+  double nsPerOp;      // mean over the corpus
+  double worstNsPerOp; // the corpus' slowest input
+  double allocsPerOp;
+};
+
+static volatile unsigned long sink; // keeps the work from being optimised away
+
+// `op(i)` runs corpus input `i` once and returns how many operations that was.
+// Rounds go through the inputs in turn, so a noisy stretch hits all of them.
+template <typename Op>
+static BenchResult bench(const char *name, size_t inputs, Op op) {
+  std::vector<double> bestNs(inputs, 1e300); // per operation, for each input
+  std::vector<unsigned long> opsPerRun(inputs, 0);
+  unsigned long ops = 0;
+  unsigned long allocs = 0;
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < inputs; i++) {
+      unsigned long inputOps = 0;
+      unsigned long allocsBefore = allocations;
+      auto start = std::chrono::steady_clock::now();
+      for (int k = 0; k < REPEATS; k++) inputOps += op(i);
+      auto end = std::chrono::steady_clock::now();
+      allocs += allocations - allocsBefore;
+      ops += inputOps;
+      opsPerRun[i] = inputOps / REPEATS;
+      double ns = std::chrono::duration<double, std::nano>(end - start).count() / inputOps;
+      if (ns < bestNs[i]) bestNs[i] = ns;
+    }
+  }
+
+  double totalNs = 0, worstNs = 0;
+  unsigned long runOps = 0;
+  for (size_t i = 0; i < inputs; i++) {
+    totalNs += bestNs[i] * opsPerRun[i];
+    runOps += opsPerRun[i];
+    if (bestNs[i] > worstNs) worstNs = bestNs[i];
+  }
+
+  BenchResult result = {totalNs / runOps, worstNs, (double)allocs / ops};
+  char line[128];
+  snprintf(line, sizeof(line), "%-24s %9.1f ns/op %9.1f ns worst %7.2f allocs/op", name,
+           result.nsPerOp, result.worstNsPerOp, result.allocsPerOp);
+  TEST_MESSAGE(line);
+  return result;
+}
+
+// Bench against its row in baseline.h, printing the row to re-record it with
+template <typename Op>
+static void benchAgainstBaseline(const char *name, size_t inputs, Op op) {
+  BenchResult result = bench(name, inputs, op);
+  char line[160];
+  snprintf(line, sizeof(line), "baseline row: {\"%s\", %.1f, %.1f, %.2f},", name,
+           result.nsPerOp, result.worstNsPerOp, result.allocsPerOp);
+  TEST_MESSAGE(line);
+
+  for (const BenchBaseline &b : BASELINE) {
+    if (strcmp(b.name, name) != 0) continue;
+    snprintf(line, sizeof(line), "%s allocates %.2f per op, baseline %.2f", name, result.allocsPerOp, b.allocsPerOp);
+    TEST_ASSERT_TRUE_MESSAGE(result.allocsPerOp <= b.allocsPerOp + 0.005, line);
+    snprintf(line, sizeof(line), "%s takes %.1f ns per op, baseline %.1f (x%.1f allowed)", name,
+             result.nsPerOp, b.nsPerOp, BENCH_TIME_TOLERANCE);
+    TEST_ASSERT_TRUE_MESSAGE(result.nsPerOp <= b.nsPerOp * BENCH_TIME_TOLERANCE, line);
+    snprintf(line, sizeof(line), "%s takes %.1f ns per op at worst, baseline %.1f (x%.1f allowed)", name,
+             result.worstNsPerOp, b.worstNsPerOp, BENCH_TIME_TOLERANCE);
+    TEST_ASSERT_TRUE_MESSAGE(result.worstNsPerOp <= b.worstNsPerOp * BENCH_TIME_TOLERANCE, line);
+    return;
+  }
+  TEST_FAIL_MESSAGE("no baseline row: add the row above to baseline.h");
+}
+
+
+// ======== parseTagPayload ========
+
+static unsigned long parseOne(size_t i) {
+  TagCommand cmd = parseTagPayload(PAYLOADS[i], strlen(PAYLOADS[i]));
+  sink += cmd.folder + cmd.volume + cmd.shuffle;
+  return 1;
+}
+
+static unsigned long legacyParseOne(size_t i) {
+  legacy::String payload(PAYLOADS[i]); // what readNdefTextFromTag() returned
+  TagCommand cmd = legacy::parseTagPayload(payload);
+  sink += cmd.folder + cmd.volume + cmd.shuffle;
+  return 1;
+}
+
+// Both parsers read the corpus the same way, so they time the same work
+static void test_parsers_agree_on_corpus() {
+  for (const char *p : PAYLOADS) {
+    TagCommand now = parseTagPayload(p, strlen(p));
+    TagCommand old = legacy::parseTagPayload(legacy::String(p));
+    TEST_ASSERT_EQUAL_MESSAGE(old.valid, now.valid, p);
+    if (!now.valid) continue;
+    TEST_ASSERT_EQUAL_MESSAGE(old.folder, now.folder, p);
+    TEST_ASSERT_EQUAL_MESSAGE(old.volume, now.volume, p);
+    TEST_ASSERT_EQUAL_MESSAGE(old.shuffle, now.shuffle, p);
+  }
+}
+
+static void test_bench_parse_tag_payload() {
+  BenchResult now = bench("parseTagPayload", ARRAY_LEN(PAYLOADS), parseOne);
+  BenchResult old = bench("parseTagPayload (String)", ARRAY_LEN(PAYLOADS), legacyParseOne);
+
+  char line[96];
+  snprintf(line, sizeof(line), "in-place parser is %.1fx faster (%.1fx at worst)",
+           old.nsPerOp / now.nsPerOp, old.worstNsPerOp / now.worstNsPerOp);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_MESSAGE(0, (unsigned long)(now.allocsPerOp * 1000), "the in-place parser allocated");
+  benchAgainstBaseline("parseTagPayload", ARRAY_LEN(PAYLOADS), parseOne);
+}
+
+
+// ======== NdefDecoder ========
+
+static char ndefOut[256]; // nfc_task.cpp's payload buffer
+
+// Decode one dump the way readNdefTextFromTag() reads a tag
+static NdefStatus decodeDump(const NtagDump &d, NdefDecoder &ndef) {
+  ndef.begin(ndefOut, sizeof(ndefOut), NDEF_RECORD_TEXT | NDEF_RECORD_URI | NDEF_RECORD_MIME);
+  NdefStatus status = NDEF_MORE;
+  for (size_t have = 0; status == NDEF_MORE && have < d.len; have += 16) {
+    status = ndef.push(d.memory + have, 16);
+  }
+  return status;
+}
+
+static unsigned long decodeOne(size_t i) {
+  NdefDecoder ndef;
+  sink += decodeDump(NTAG_DUMPS[i], ndef) + ndef.record().length;
+  return 1;
+}
+
+static void test_ndef_decodes_corpus() {
+  NdefDecoder ndef;
+  for (const NtagDump &d : NTAG_DUMPS) {
+    NdefStatus status = decodeDump(d, ndef);
+    if (!d.text) {
+      TEST_ASSERT_EQUAL_MESSAGE(NDEF_NOT_FOUND, status, d.name);
+      continue;
+    }
+    TEST_ASSERT_EQUAL_MESSAGE(NDEF_DONE, status, d.name);
+    size_t want = strlen(d.text) < sizeof(ndefOut) ? strlen(d.text) : sizeof(ndefOut) - 1;
+    TEST_ASSERT_EQUAL_MESSAGE(want, ndef.record().length, d.name);
+    TEST_ASSERT_EQUAL_MESSAGE(want < strlen(d.text), ndef.record().truncated, d.name);
+    TEST_ASSERT_EQUAL_MESSAGE(0, strncmp(d.text, ndefOut, want), d.name);
+  }
+}
+
+static void test_bench_ndef_decoder() {
+  benchAgainstBaseline("NdefDecoder", ARRAY_LEN(NTAG_DUMPS), decodeOne);
+}
+
+
+// ======== Button traces ========
+
+struct Gestures {
+  uint8_t shorts, longs, repeats;
+};
+
+static void count(Gestures &g, ButtonAction action) {
+  if (action == BUTTON_SHORT) g.shorts++;
+  if (action == BUTTON_LONG) g.longs++;
+  if (action == BUTTON_REPEAT) g.repeats++;
+}
+
+// Replay a trace starting at `startUs` (a volume button: holds repeat)
+static Gestures replay(const ButtonTrace &t, uint32_t startUs) {
+  ButtonState s = {};
+  Gestures g = {};
+  uint32_t dueUs;
+  for (size_t i = 0; i < t.count; i++) {
+    uint32_t atUs = startUs + t.edges[i].atMs * 1000UL;
+    ButtonAction action;
+    while ((action = buttonHeld(s, atUs, true, dueUs)) != BUTTON_NONE) count(g, action);
+    count(g, buttonEdge(s, t.edges[i].pressed, atUs));
+  }
+  return g;
+}
+
+static unsigned long replayOne(size_t i) {
+  static uint32_t startUs = 0; // moves on each run, wrapping like micros()
+  Gestures g = replay(BUTTON_TRACES[i], startUs);
+  sink += g.shorts + g.longs + g.repeats;
+  startUs += 0x10000001UL;
+  return BUTTON_TRACES[i].count;
+}
+
+static void test_button_traces_make_their_gestures() {
+  for (uint32_t startUs : {0UL, 0xFFFFF000UL}) { // the second one wraps mid-trace
+    for (const ButtonTrace &t : BUTTON_TRACES) {
+      Gestures g = replay(t, startUs);
+      TEST_ASSERT_EQUAL_MESSAGE(t.shorts, g.shorts, t.name);
+      TEST_ASSERT_EQUAL_MESSAGE(t.longs, g.longs, t.name);
+      TEST_ASSERT_EQUAL_MESSAGE(t.repeats, g.repeats, t.name);
+    }
+  }
+}
+
+static void test_bench_button_traces() {
+  benchAgainstBaseline("button traces", ARRAY_LEN(BUTTON_TRACES), replayOne);
+}
+
+
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parsers_agree_on_corpus);
+  RUN_TEST(test_bench_parse_tag_payload);
+  RUN_TEST(test_ndef_decodes_corpus);
+  RUN_TEST(test_bench_ndef_decoder);
+  RUN_TEST(test_button_traces_make_their_gestures);
+  RUN_TEST(test_bench_button_traces);
+  return UNITY_END();
+}
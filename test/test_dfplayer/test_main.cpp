@@ -0,0 +1,336 @@
+// DFPlayer frame codec and driver, against a scripted serial port
+//
+//   pio test -e native -f test_dfplayer
+//
+// The port stands in for the module: the test reads what the driver wrote and
+// hands it frames back, raising the receive event like the UART does. Time is
+// the sim's virtual clock (lib/sim), moved on with delay().
+
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "df_frame.h"
+#include "dfplayer.h"
+
+class ScriptedPort : public SerialPort {
+public:
+  void begin() override {}
+  int available() override { return (int)(rx.size() - rxPos); }
+  int read() override { return rxPos < rx.size() ? rx[rxPos++] : -1; }
+  size_t write(const uint8_t *buf, size_t len) override {
+    tx.insert(tx.end(), buf, buf + len);
+    return len;
+  }
+  void onReceive(SerialRxFn fn, void *ctx) override {
+    rxFn = fn;
+    rxCtx = ctx;
+  }
+
+  // Bytes from the module
+  void feed(const uint8_t *buf, size_t len) {
+    rx.insert(rx.end(), buf, buf + len);
+    if (rxFn) rxFn(rxCtx);
+  }
+  void feedFrame(uint8_t cmd, uint16_t param) {
+    uint8_t buf[DF_FRAME_LEN];
+    dfEncodeFrame({cmd, false, param}, buf);
+    feed(buf, sizeof(buf));
+  }
+
+  size_t framesSent() const { return tx.size() / DF_FRAME_LEN; }
+  DFFrame sent(size_t i) const {
+    DFFrameDecoder d;
+    DFFrame f = {};
+    for (size_t b = 0; b < DF_FRAME_LEN; b++) d.push(tx[i * DF_FRAME_LEN + b], f);
+    return f;
+  }
+
+  std::vector<uint8_t> rx, tx;
+  size_t rxPos = 0;
+  SerialRxFn rxFn = nullptr;
+  void *rxCtx = nullptr;
+};
+
+static ScriptedPort *port;
+static DFPlayer *df;
+
+struct Answer {
+  int calls;
+  uint8_t cmd;
+  bool ok;
+  uint16_t value;
+};
+static Answer answer;
+
+struct Event {
+  int calls;
+  uint8_t event;
+  uint16_t param;
+};
+static Event lastEvent;
+
+static void onAnswer(uint8_t cmd, bool ok, uint16_t value) {
+  answer = {answer.calls + 1, cmd, ok, value};
+}
+
+static void onEvent(uint8_t event, uint16_t param) {
+  lastEvent = {lastEvent.calls + 1, event, param};
+}
+
+// A driver that is past its reset, with nothing on the wire
+static void bringOnline() {
+  df->begin(*port);
+  df->service();
+  port->feedFrame(DF_EVT_ONLINE, 0x02);
+  df->service();
+  port->tx.clear();
+  lastEvent = {};
+}
+
+void setUp() {
+  port = new ScriptedPort();
+  df = new DFPlayer();
+  df->onEvent(onEvent);
+  answer = {};
+  lastEvent = {};
+}
+
+void tearDown() {
+  delete df;
+  delete port;
+}
+
+
+// ======== Codec ========
+
+static void test_frame_round_trip() {
+  uint8_t buf[DF_FRAME_LEN];
+  dfEncodeFrame({DF_CMD_PLAY_FOLDER, true, 0x0703}, buf);
+
+  const uint8_t expected[DF_FRAME_LEN] = {0x7E, 0xFF, 0x06, 0x0F, 0x01, 0x07, 0x03, 0xFE, 0xE1, 0xEF};
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, DF_FRAME_LEN);
+
+  DFFrameDecoder d;
+  DFFrame f = {};
+  for (uint8_t i = 0; i < DF_FRAME_LEN - 1; i++) TEST_ASSERT_FALSE(d.push(buf[i], f));
+  TEST_ASSERT_TRUE(d.push(buf[DF_FRAME_LEN - 1], f));
+  TEST_ASSERT_EQUAL_HEX8(DF_CMD_PLAY_FOLDER, f.cmd);
+  TEST_ASSERT_TRUE(f.feedback);
+  TEST_ASSERT_EQUAL_HEX16(0x0703, f.param);
+}
+
+static void test_bad_checksum_is_dropped() {
+  uint8_t buf[DF_FRAME_LEN];
+  dfEncodeFrame({DF_EVT_TRACK_FINISHED, false, 5}, buf);
+  buf[8] ^= 0x01;
+
+  DFFrameDecoder d;
+  DFFrame f = {};
+  for (uint8_t i = 0; i < DF_FRAME_LEN; i++) TEST_ASSERT_FALSE(d.push(buf[i], f));
+  TEST_ASSERT_EQUAL_UINT32(1, d.checksumErrors);
+}
+
+static void test_bad_end_byte_is_dropped() {
+  uint8_t buf[DF_FRAME_LEN];
+  dfEncodeFrame({DF_EVT_ACK, false, 0}, buf);
+  buf[9] = 0x00;
+
+  DFFrameDecoder d;
+  DFFrame f = {};
+  for (uint8_t i = 0; i < DF_FRAME_LEN; i++) TEST_ASSERT_FALSE(d.push(buf[i], f));
+  TEST_ASSERT_EQUAL_UINT32(1, d.framingErrors);
+}
+
+// Line noise and a frame cut short: the frames after them still come through
+static void test_decoder_resyncs_after_noise_and_truncation() {
+  uint8_t a[DF_FRAME_LEN], b[DF_FRAME_LEN];
+  dfEncodeFrame({DF_EVT_ONLINE, false, 2}, a);
+  dfEncodeFrame({DF_EVT_TRACK_FINISHED, false, 9}, b);
+
+  std::vector<uint8_t> stream = {0x00, 0x55, 0xEF};  // power-up noise
+  stream.insert(stream.end(), a, a + 4);             // truncated frame...
+  stream.insert(stream.end(), a, a + DF_FRAME_LEN);  // ...whose window swallows part of this one
+  stream.insert(stream.end(), b, b + DF_FRAME_LEN);
+
+  DFFrameDecoder d;
+  DFFrame f = {};
+  std::vector<DFFrame> got;
+  for (uint8_t byte : stream) {
+    if (d.push(byte, f)) got.push_back(f);
+  }
+
+  TEST_ASSERT_EQUAL(1, got.size());
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_TRACK_FINISHED, got[0].cmd);
+  TEST_ASSERT_EQUAL_HEX16(9, got[0].param);
+  TEST_ASSERT_TRUE(d.framingErrors > 0);
+}
+
+
+// ======== Driver ========
+
+static void test_reset_completes_on_online_frame() {
+  df->begin(*port, onAnswer);
+  TEST_ASSERT_FALSE(df->online());
+
+  df->service();
+  TEST_ASSERT_EQUAL(1, port->framesSent());
+  TEST_ASSERT_EQUAL_HEX8(DF_CMD_RESET, port->sent(0).cmd);
+  TEST_ASSERT_FALSE(port->sent(0).feedback); // the module answers a reset with 0x3F, not an ACK
+
+  port->feedFrame(DF_EVT_ONLINE, 0x02);
+  df->service();
+  TEST_ASSERT_TRUE(df->online());
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_TRUE(answer.ok);
+  TEST_ASSERT_EQUAL(1, lastEvent.calls); // and the event handler hears it too
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_ONLINE, lastEvent.event);
+}
+
+static void test_reset_times_out() {
+  df->begin(*port, onAnswer);
+  df->service();
+  delay(DFPlayer::RESET_TIMEOUT_MS + 1);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_FALSE(answer.ok);
+  TEST_ASSERT_FALSE(df->online());
+  TEST_ASSERT_EQUAL_UINT32(1, df->timeouts);
+}
+
+static void test_one_command_on_the_wire_until_acked() {
+  bringOnline();
+  df->volume(12, onAnswer);
+  df->playFolder(7, 3);
+
+  df->service();
+  TEST_ASSERT_EQUAL(1, port->framesSent());
+  TEST_ASSERT_EQUAL_HEX8(DF_CMD_VOLUME, port->sent(0).cmd);
+  TEST_ASSERT_TRUE(port->sent(0).feedback);
+  TEST_ASSERT_EQUAL_HEX16(12, port->sent(0).param);
+
+  df->service();
+  TEST_ASSERT_EQUAL(1, port->framesSent()); // still waiting for the ACK
+  TEST_ASSERT_FALSE(df->idle());
+
+  port->feedFrame(DF_EVT_ACK, 0);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_TRUE(answer.ok);
+  TEST_ASSERT_EQUAL_HEX8(DF_CMD_VOLUME, answer.cmd);
+  TEST_ASSERT_EQUAL(2, port->framesSent());
+  TEST_ASSERT_EQUAL_HEX8(DF_CMD_PLAY_FOLDER, port->sent(1).cmd);
+  TEST_ASSERT_EQUAL_HEX16(0x0703, port->sent(1).param);
+  TEST_ASSERT_EQUAL(0, lastEvent.calls); // an ACK is an answer, not an event
+}
+
+static void test_command_times_out_and_late_ack_is_dropped() {
+  bringOnline();
+  df->playFolder(1, 1, onAnswer);
+  df->service();
+
+  delay(DFPlayer::DEFAULT_TIMEOUT_MS + 1);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_FALSE(answer.ok);
+  TEST_ASSERT_EQUAL_UINT32(1, df->timeouts);
+  TEST_ASSERT_TRUE(df->idle());
+
+  port->feedFrame(DF_EVT_ACK, 0);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_EQUAL(0, lastEvent.calls);
+}
+
+static void test_error_frame_fails_the_command() {
+  bringOnline();
+  df->playFolder(99, 1, onAnswer);
+  df->service();
+
+  port->feedFrame(DF_EVT_ERROR, 0x06); // file not found
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_FALSE(answer.ok);
+  TEST_ASSERT_EQUAL_HEX16(0x06, answer.value);
+  TEST_ASSERT_EQUAL_UINT32(1, df->errors);
+  TEST_ASSERT_EQUAL(1, lastEvent.calls);
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_ERROR, lastEvent.event);
+  TEST_ASSERT_TRUE(df->idle());
+}
+
+// 0x3D arriving while a command waits for its ACK is an event, not the answer
+static void test_track_finished_is_an_event() {
+  bringOnline();
+  df->playFolder(2, 4, onAnswer);
+  df->service();
+
+  port->feedFrame(DF_EVT_TRACK_FINISHED, 17);
+  df->service();
+  TEST_ASSERT_EQUAL(1, lastEvent.calls);
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_TRACK_FINISHED, lastEvent.event);
+  TEST_ASSERT_EQUAL_HEX16(17, lastEvent.param);
+  TEST_ASSERT_EQUAL(0, answer.calls);
+  TEST_ASSERT_FALSE(df->idle());
+
+  port->feedFrame(DF_EVT_ACK, 0);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_TRUE(answer.ok);
+}
+
+// The module resetting by itself: online again, the driver tells the app
+static void test_unsolicited_online_is_an_event() {
+  bringOnline();
+  port->feedFrame(DF_EVT_ONLINE, 0x02);
+  df->service();
+  TEST_ASSERT_EQUAL(1, lastEvent.calls);
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_ONLINE, lastEvent.event);
+  TEST_ASSERT_TRUE(df->online());
+}
+
+static void test_query_is_answered_with_its_own_command() {
+  bringOnline();
+  df->queryVolume(onAnswer);
+  df->service();
+  TEST_ASSERT_FALSE(port->sent(0).feedback);
+
+  port->feedFrame(DF_QUERY_VOLUME, 21);
+  df->service();
+  TEST_ASSERT_EQUAL(1, answer.calls);
+  TEST_ASSERT_TRUE(answer.ok);
+  TEST_ASSERT_EQUAL_HEX16(21, answer.value);
+  TEST_ASSERT_EQUAL(0, lastEvent.calls);
+}
+
+// A frame split across two receive events decodes once the rest arrives
+static void test_frame_split_across_receive_events() {
+  bringOnline();
+  uint8_t buf[DF_FRAME_LEN];
+  dfEncodeFrame({DF_EVT_CARD_REMOVED, false, 2}, buf);
+
+  port->feed(buf, 6);
+  df->service();
+  TEST_ASSERT_EQUAL(0, lastEvent.calls);
+
+  port->feed(buf + 6, DF_FRAME_LEN - 6);
+  df->service();
+  TEST_ASSERT_EQUAL(1, lastEvent.calls);
+  TEST_ASSERT_EQUAL_HEX8(DF_EVT_CARD_REMOVED, lastEvent.event);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_round_trip);
+  RUN_TEST(test_bad_checksum_is_dropped);
+  RUN_TEST(test_bad_end_byte_is_dropped);
+  RUN_TEST(test_decoder_resyncs_after_noise_and_truncation);
+  RUN_TEST(test_reset_completes_on_online_frame);
+  RUN_TEST(test_reset_times_out);
+  RUN_TEST(test_one_command_on_the_wire_until_acked);
+  RUN_TEST(test_command_times_out_and_late_ack_is_dropped);
+  RUN_TEST(test_error_frame_fails_the_command);
+  RUN_TEST(test_track_finished_is_an_event);
+  RUN_TEST(test_unsolicited_online_is_an_event);
+  RUN_TEST(test_query_is_answered_with_its_own_command);
+  RUN_TEST(test_frame_split_across_receive_events);
+  return UNITY_END();
+}
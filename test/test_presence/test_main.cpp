@@ -0,0 +1,95 @@
+// Presence checks on the tag that stays on the reader, against the whole
+// firmware running on the sim (lib/sim)
+//
+//   pio test -e native -f test_presence
+//
+// setup() runs once; each test moves the virtual clock on with loop() and
+// places or takes off tags the way a script would.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+static void runFor(unsigned long ms) {
+  unsigned long until = millis() + ms;
+  while ((long)(millis() - until) < 0) loop();
+}
+
+static void place(const char *uidHex, bool refusesRead) {
+  SimTag tag;
+  TEST_ASSERT_TRUE(simBuildTextTag(uidHex, "07 | volume 5", tag));
+  tag.refusesRead = refusesRead;
+  simPlaceTag(tag);
+}
+
+// Take the tag off and wait until the box has noticed
+static void removeTag() {
+  simRemoveTag();
+  runFor(TAG_REMOVAL_DEBOUNCE + 2000);
+  TEST_ASSERT_FALSE(tagPresent);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+
+static void test_ntag_stays_present_on_page_reads() {
+  place("04A1B2C3D4E5F6", false);
+  runFor(1000);
+  TEST_ASSERT_TRUE(tagPresent);
+
+  uint32_t before = simNfcPageZeroReads();
+  runFor(5000);
+  TEST_ASSERT_TRUE(tagPresent);
+  TEST_ASSERT_TRUE(simNfcPageZeroReads() - before >= 5); // one per poll
+
+  removeTag();
+}
+
+static void test_tag_refusing_read_is_asked_once() {
+  uint32_t before = simNfcPageZeroReads();
+  place("A1B2C3D4", true);
+  runFor(1000);
+  TEST_ASSERT_TRUE(tagPresent);
+
+  // Full detections keep it present; the READ it refused isn't sent again
+  runFor(5000);
+  TEST_ASSERT_TRUE(tagPresent);
+  TEST_ASSERT_EQUAL(1, simNfcPageZeroReads() - before);
+
+  removeTag();
+}
+
+static void test_next_tag_gets_page_reads_again() {
+  place("A1B2C3D4", true);
+  runFor(2000);
+  removeTag();
+
+  place("04A1B2C3D4E5F6", false);
+  runFor(1000);
+  uint32_t before = simNfcPageZeroReads();
+  runFor(5000);
+  TEST_ASSERT_TRUE(tagPresent);
+  TEST_ASSERT_TRUE(simNfcPageZeroReads() - before >= 5);
+
+  removeTag();
+}
+
+int main(int argc, char **argv) {
+  simSetPin(Switch_pin, LOW);   // power switch on, as sim_main.cpp does
+  simSetNfcIrqPin(NFC_IRQ_pin);
+  simSetDFPlayerBusyPin(DF_BUSY_pin);
+  setup();
+  runFor(3000); // boot
+
+  UNITY_BEGIN();
+  RUN_TEST(test_ntag_stays_present_on_page_reads);
+  RUN_TEST(test_tag_refusing_read_is_asked_once);
+  RUN_TEST(test_next_tag_gets_page_reads_again);
+  return UNITY_END();
+}